@@ -0,0 +1,63 @@
+#include "allocationcounter.h"
+
+AllocationCounter::CountingMatAllocator AllocationCounter::matAllocator;
+std::atomic<quint64> AllocationCounter::newCount(0);
+std::atomic<quint64> AllocationCounter::matCount(0);
+
+/*
+ * Count cv::Mat allocations from now on (operator new is always counted)
+ */
+void AllocationCounter::install() {
+    if (matAllocator.base == nullptr) {
+        matAllocator.base = cv::Mat::getStdAllocator();
+        cv::Mat::setDefaultAllocator(&matAllocator);
+    }
+}
+
+quint64 AllocationCounter::getNewCount() {
+    return newCount.load();
+}
+
+quint64 AllocationCounter::getMatCount() {
+    return matCount.load();
+}
+
+/*
+ * Buffers are allocated (and later freed) by OpenCV's own allocator, which marks itself as their owner
+ */
+cv::UMatData * AllocationCounter::CountingMatAllocator::allocate(int dims, const int * sizes, int type, void * data,
+                                                                 size_t * step, int flags,
+                                                                 cv::UMatUsageFlags usageFlags) const {
+    if (data == nullptr) {
+        matCount++;
+    }
+    return base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+}
+
+bool AllocationCounter::CountingMatAllocator::allocate(cv::UMatData * data, int accessFlags,
+                                                       cv::UMatUsageFlags usageFlags) const {
+    return base->allocate(data, accessFlags, usageFlags);
+}
+
+void AllocationCounter::CountingMatAllocator::deallocate(cv::UMatData * data) const {
+    base->deallocate(data);
+}
+
+// Every other form of new & delete (arrays, nothrow) goes through these by default
+
+void * operator new(std::size_t size) {
+    AllocationCounter::newCount++;
+    void * ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void * ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
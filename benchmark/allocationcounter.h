@@ -0,0 +1,42 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+// Implementation classes
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <QtGlobal>
+
+#include <opencv2/core.hpp>
+
+/*
+ * Counts heap allocations made by the code being benchmarked: every operator new (replaced globally in
+ * this target), and every cv::Mat buffer (through a default allocator that counts, then uses OpenCV's own).
+ * QImage buffers are allocated with malloc, so they are only counted when converted through a cv::Mat
+ */
+class AllocationCounter {
+
+private:
+    class CountingMatAllocator : public cv::MatAllocator {
+    public:
+        cv::MatAllocator * base = nullptr;
+
+        cv::UMatData * allocate(int dims, const int * sizes, int type, void * data, size_t * step,
+                                int flags, cv::UMatUsageFlags usageFlags) const;
+        bool allocate(cv::UMatData * data, int accessFlags, cv::UMatUsageFlags usageFlags) const;
+        void deallocate(cv::UMatData * data) const;
+    };
+
+    static CountingMatAllocator matAllocator;
+
+public:
+    static std::atomic<quint64> newCount;
+    static std::atomic<quint64> matCount;
+
+    static void install();
+    static quint64 getNewCount();
+    static quint64 getMatCount();
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,269 @@
+#include "allocationcounter.h"
+#include "../syntheticsource.h"
+#include "../webcamplayer.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+
+/*
+ * Headless benchmark of the image pipeline (processImage, convertMatToQImage & convertQImageToMat)
+ * over resolutions, rotation angles, filters and colour/grey input. Inputs are the same generated
+ * page on every run, and results are written as JSON that can be compared against an earlier run
+ */
+
+struct Config {
+    QString resolution;
+    cv::Size size;
+    int angle;
+    QString filter;
+    bool isColor;
+};
+
+struct Measurement {
+    int iterations = 0;
+    double medianNs = 0;
+    double minNs = 0;
+    double matAllocations = 0;
+    double newAllocations = 0;
+};
+
+static const int MIN_ITERATIONS = 3;
+static const int MAX_ITERATIONS = 1000;
+
+/*
+ * Run repeatedly (after one warm-up run) until both the minimum time and iterations are reached
+ */
+static Measurement measure(const std::function<void()> & run, qint64 minTimeMs) {
+    run();
+
+    // Room for the times is reserved up front, so that recording them isn't counted as an allocation
+    std::vector<double> times;
+    times.reserve(MAX_ITERATIONS);
+
+    QElapsedTimer total;
+    total.start();
+    quint64 matStart = AllocationCounter::getMatCount();
+    quint64 newStart = AllocationCounter::getNewCount();
+    while (int(times.size()) < MAX_ITERATIONS
+           && (int(times.size()) < MIN_ITERATIONS || total.elapsed() < minTimeMs)) {
+        QElapsedTimer timer;
+        timer.start();
+        run();
+        times.push_back(double(timer.nsecsElapsed()));
+    }
+
+    Measurement result;
+    result.iterations = int(times.size());
+    result.matAllocations = double(AllocationCounter::getMatCount() - matStart) / result.iterations;
+    result.newAllocations = double(AllocationCounter::getNewCount() - newStart) / result.iterations;
+
+    std::sort(times.begin(), times.end());
+    result.medianNs = times[times.size() / 2];
+    result.minNs = times.front();
+
+    return result;
+}
+
+/*
+ * Identifies a configuration across runs, to compare against a baseline
+ */
+static QString getResultKey(const QJsonObject & result) {
+    return QString("%1 %2x%3 %4deg %5 %6")
+            .arg(result["function"].toString())
+            .arg(result["width"].toInt())
+            .arg(result["height"].toInt())
+            .arg(result["angle"].toInt())
+            .arg(result["filter"].toString())
+            .arg(result["color"].toBool() ? "colour" : "grey");
+}
+
+static QJsonObject toJson(const QString & function, const Config & config, const Measurement & measurement) {
+    double pixels = double(config.size.area());
+
+    QJsonObject result;
+    result["function"] = function;
+    result["resolution"] = config.resolution;
+    result["width"] = config.size.width;
+    result["height"] = config.size.height;
+    result["angle"] = config.angle;
+    result["filter"] = config.filter;
+    result["color"] = config.isColor;
+    result["iterations"] = measurement.iterations;
+    result["medianNs"] = measurement.medianNs;
+    result["minNs"] = measurement.minNs;
+    result["fps"] = 1e9 / measurement.medianNs;
+    result["nsPerPixel"] = measurement.medianNs / pixels;
+    result["matAllocations"] = measurement.matAllocations;
+    result["newAllocations"] = measurement.newAllocations;
+
+    return result;
+}
+
+static void printResult(const QJsonObject & result) {
+    printf("%-18s %-5s %4d deg  %-16s %-6s %9.1f fps %8.3f ns/px %6.1f mat %7.1f new\n",
+           qPrintable(result["function"].toString()),
+           qPrintable(result["resolution"].toString()),
+           result["angle"].toInt(),
+           qPrintable(result["filter"].toString()),
+           result["color"].toBool() ? "colour" : "grey",
+           result["fps"].toDouble(),
+           result["nsPerPixel"].toDouble(),
+           result["matAllocations"].toDouble(),
+           result["newAllocations"].toDouble());
+    fflush(stdout);
+}
+
+/*
+ * Print how each configuration changed since the baseline run. Returns how many got slower than the threshold
+ */
+static int compareWithBaseline(const QJsonArray & results, const QString & baselinePath, double thresholdPercent) {
+    QFile file(baselinePath);
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical("Cannot read baseline: %s", qPrintable(baselinePath));
+        return -1;
+    }
+
+    QHash<QString, double> baselineNs;
+    for (const QJsonValue & value : QJsonDocument::fromJson(file.readAll()).object()["results"].toArray()) {
+        QJsonObject result = value.toObject();
+        baselineNs[getResultKey(result)] = result["medianNs"].toDouble();
+    }
+
+    int regressions = 0;
+    printf("\nChange since %s (slower than +%.0f%% is a regression):\n", qPrintable(baselinePath), thresholdPercent);
+    for (const QJsonValue & value : results) {
+        QJsonObject result = value.toObject();
+        QString key = getResultKey(result);
+        if (!baselineNs.contains(key) || baselineNs[key] <= 0) {
+            continue;
+        }
+
+        double change = (result["medianNs"].toDouble() / baselineNs[key] - 1) * 100;
+        bool isRegression = change > thresholdPercent;
+        if (isRegression) {
+            regressions++;
+        }
+        printf("%-60s %+7.1f%%%s\n", qPrintable(key), change, isRegression ? "  REGRESSION" : "");
+    }
+    printf("%d regression(s)\n", regressions);
+
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    AllocationCounter::install();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the MagniRead image pipeline.");
+    QCommandLineOption outputOption("output", "Write results to <file> (default benchmark.json).", "file", "benchmark.json");
+    QCommandLineOption baselineOption("baseline", "Compare results with an earlier run's <file>.", "file");
+    QCommandLineOption thresholdOption("threshold", "Slowdown in <percent> counted as a regression (default 10).", "percent", "10");
+    QCommandLineOption minTimeOption("min-time", "Time spent measuring each configuration, in <ms> (default 200).", "ms", "200");
+    QCommandLineOption quickOption("quick", "Only measure 720p and 1080p.");
+    parser.addOptions({outputOption, baselineOption, thresholdOption, minTimeOption, quickOption});
+    parser.addHelpOption();
+    parser.process(app);
+
+    qint64 minTimeMs = parser.value(minTimeOption).toLongLong();
+
+    QList<QPair<QString, cv::Size>> resolutions = {
+        {"720p", cv::Size(1280, 720)},
+        {"1080p", cv::Size(1920, 1080)},
+        {"1440p", cv::Size(2560, 1440)},
+        {"4K", cv::Size(3840, 2160)},
+        {"8K", cv::Size(7680, 4320)},
+    };
+    if (parser.isSet(quickOption)) {
+        resolutions = resolutions.mid(0, 2);
+    }
+    QList<int> angles = {0, 5, 45, 90, 180, 270};
+    QStringList filters = {"None", "Greyscale", "Black and White"};
+
+    ImageSettings settings;
+    settings.contrast = 1.5;
+    settings.brightness = 20;
+
+    QJsonArray results;
+    for (const auto & resolution : resolutions) {
+        // Same generated page every run
+        SyntheticSource source(resolution.second, 0);
+        cv::Mat colorFrame;
+        if (!source.open() || !source.read(colorFrame)) {
+            qCritical("Cannot generate %s input", qPrintable(resolution.first));
+            return 1;
+        }
+        cv::Mat greyFrame;
+        cv::cvtColor(colorFrame, greyFrame, CV_BGR2GRAY);
+
+        for (bool isColor : {true, false}) {
+            cv::Mat input = isColor ? colorFrame : greyFrame;
+
+            for (int angle : angles) {
+                for (const QString & filter : filters) {
+                    Config config = {resolution.first, resolution.second, angle, filter, isColor};
+                    settings.angle = angle;
+                    settings.filter = filter.toStdString();
+
+                    cv::Mat processed;
+                    Measurement processing = measure([&]() {
+                        processed = WebcamPlayer::processImage(input, settings);
+                    }, minTimeMs);
+                    results.append(toJson("processImage", config, processing));
+                    printResult(results.last().toObject());
+
+                    QImage image;
+                    Measurement toQImage = measure([&]() {
+                        image = WebcamPlayer::convertMatToQImage(processed, settings.isBinary());
+                    }, minTimeMs);
+                    results.append(toJson("convertMatToQImage", config, toQImage));
+                    printResult(results.last().toObject());
+
+                    cv::Mat converted;
+                    Measurement toMat = measure([&]() {
+                        converted = WebcamPlayer::convertQImageToMat(image);
+                    }, minTimeMs);
+                    results.append(toJson("convertQImageToMat", config, toMat));
+                    printResult(results.last().toObject());
+                }
+            }
+        }
+    }
+
+    QJsonObject report;
+    report["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["qtVersion"] = QString(qVersion());
+    report["opencvVersion"] = QString(CV_VERSION);
+    report["opencvThreads"] = cv::getNumThreads();
+    report["minTimeMs"] = minTimeMs;
+    report["results"] = results;
+
+    QFile file(parser.value(outputOption));
+    if (!file.open(QFile::WriteOnly) || file.write(QJsonDocument(report).toJson()) < 0) {
+        qCritical("Cannot write results: %s", qPrintable(file.fileName()));
+        return 1;
+    }
+    printf("Results written to %s\n", qPrintable(file.fileName()));
+
+    if (parser.isSet(baselineOption)) {
+        int regressions = compareWithBaseline(results, parser.value(baselineOption), parser.value(thresholdOption).toDouble());
+        if (regressions != 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+# Headless benchmark of the image pipeline (see README). Build in release mode for meaningful numbers
+QT       += core gui
+QT       -= widgets
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = magniread-benchmark
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+# OpenCV from pkg-config, or from OPENCV_DIR (the OpenCV build folder set up as in the README)
+isEmpty(OPENCV_DIR): OPENCV_DIR = $$(OPENCV_DIR)
+unix:isEmpty(OPENCV_DIR) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv
+}
+else {
+    INCLUDEPATH += $$OPENCV_DIR/install/include
+    OPENCV_MODULES = core videoio highgui imgproc imgcodecs flann features2d calib3d
+    for(module, OPENCV_MODULES) {
+        win32: LIBS += $$OPENCV_DIR/bin/libopencv_$${module}320.dll
+        else: LIBS += -L$$OPENCV_DIR/install/lib -lopencv_$${module}
+    }
+}
+
+SOURCES += \
+    benchmark.cpp \
+    allocationcounter.cpp \
+    ../webcamplayer.cpp \
+    ../imagepipeline.cpp \
+    ../qualitygovernor.cpp \
+    ../framemailbox.cpp \
+    ../binaryimage.cpp \
+    ../captureopener.cpp \
+    ../framesource.cpp \
+    ../camerasource.cpp \
+    ../syntheticsource.cpp \
+    ../pagestitcher.cpp \
+    ../mosaiccanvas.cpp \
+    ../pipelinemetrics.cpp \
+    ../latencyhistogram.cpp \
+    ../tracer.cpp
+
+HEADERS += \
+    allocationcounter.h \
+    ../webcamplayer.h \
+    ../imagepipeline.h \
+    ../qualitygovernor.h \
+    ../framemailbox.h \
+    ../binaryimage.h \
+    ../imagesettings.h \
+    ../captureopener.h \
+    ../framesource.h \
+    ../camerasource.h \
+    ../syntheticsource.h \
+    ../pagestitcher.h \
+    ../mosaiccanvas.h \
+    ../pipelinemetrics.h \
+    ../latencyhistogram.h \
+    ../tracer.h
@@ -0,0 +1,67 @@
+#include "binaryimage.h"
+
+/*
+ * Pack a single channel image, where every pixel that isn't 0 becomes white
+ */
+QImage BinaryImage::pack(const cv::Mat & binary) {
+    if (binary.empty() || binary.type() != CV_8UC1) {
+        return QImage();
+    }
+
+    QImage img(binary.cols, binary.rows, QImage::Format_Mono);
+    img.setColorTable(QVector<QRgb>{qRgb(0, 0, 0), qRgb(255, 255, 255)});
+
+    for (int y = 0; y < binary.rows; y++) {
+        const uchar * in = binary.ptr(y);
+        uchar * out = img.scanLine(y);
+        for (int x = 0; x < binary.cols; x += 8) {
+            int count = qMin(8, binary.cols - x);
+            uchar byte = 0;
+            for (int bit = 0; bit < count; bit++) {
+                byte |= uchar((in[x + bit] != 0) << (7 - bit));
+            }
+            out[x >> 3] = byte;
+        }
+    }
+
+    return img;
+}
+
+/*
+ * One byte per pixel (its grey level in the colour table) for a region of a packed image (all of it by default)
+ */
+cv::Mat BinaryImage::unpack(const QImage & img, QRect region) {
+    region = region.isNull() ? img.rect() : (region & img.rect());
+    if (img.format() != QImage::Format_Mono || region.isEmpty()) {
+        return cv::Mat();
+    }
+
+    uchar levels[2] = {0, 255};
+    for (int i = 0; i < qMin(2, img.colorCount()); i++) {
+        levels[i] = uchar(qGray(img.color(i)));
+    }
+
+    cv::Mat unpacked(region.height(), region.width(), CV_8UC1);
+    for (int y = 0; y < region.height(); y++) {
+        const uchar * in = img.constScanLine(region.y() + y);
+        uchar * out = unpacked.ptr(y);
+        for (int x = 0; x < region.width(); x++) {
+            int column = region.x() + x;
+            out[x] = levels[(in[column >> 3] >> (7 - (column & 7))) & 1];
+        }
+    }
+
+    return unpacked;
+}
+
+/*
+ * Grey image (QImage::Format_Grayscale8) of a packed image, for drawing. Images that aren't packed are returned as they are
+ */
+QImage BinaryImage::expand(const QImage & img) {
+    if (img.format() != QImage::Format_Mono) {
+        return img;
+    }
+
+    cv::Mat unpacked = unpack(img);
+    return QImage(unpacked.data, unpacked.cols, unpacked.rows, int(unpacked.step), QImage::Format_Grayscale8).copy();
+}
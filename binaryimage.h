@@ -0,0 +1,23 @@
+#ifndef BINARYIMAGE_H
+#define BINARYIMAGE_H
+
+// Implementation classes
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+#include <opencv2/core.hpp>
+
+/*
+ * Black & white images packed to 1 bit per pixel (QImage::Format_Mono, most significant bit first), which is
+ * 8 times smaller than one byte per pixel. Bit 0 is black and bit 1 is white
+ */
+class BinaryImage {
+
+public:
+    static QImage pack(const cv::Mat & binary);
+    static cv::Mat unpack(const QImage & img, QRect region = QRect());
+    static QImage expand(const QImage & img);
+};
+
+#endif // BINARYIMAGE_H
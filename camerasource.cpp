@@ -0,0 +1,84 @@
+#include "camerasource.h"
+
+CameraSource::CameraSource(int device) {
+    this->device = device;
+}
+
+int CameraSource::getDevice() const {
+    return device;
+}
+
+/*
+ * Open the webcam at its best resolution and warm it up. Reopening skips looking for the best resolution
+ */
+bool CameraSource::open() {
+    if (!capture.open(device)) {
+        return false;
+    }
+
+    bool isReopened = (resolution.area() > 0);
+    if (isReopened) {
+        capture.set(cv::CAP_PROP_FRAME_WIDTH, resolution.width);
+        capture.set(cv::CAP_PROP_FRAME_HEIGHT, resolution.height);
+    }
+    else {
+        useMaxResolution();
+        resolution = cv::Size(int(capture.get(cv::CAP_PROP_FRAME_WIDTH)), int(capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    }
+    // Webcams report their nominal rate (0 if they can't tell)
+    fps = capture.get(cv::CAP_PROP_FPS);
+
+    cv::Mat frame;
+    int warmupFrames = isReopened ? RESUME_WARMUP_FRAMES : WARMUP_FRAMES;
+    for (int i = 0; i < warmupFrames; i++) {
+        if (!capture.read(frame)) {
+            capture.release();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CameraSource::isOpened() const {
+    return capture.isOpened();
+}
+
+bool CameraSource::read(cv::Mat & frame) {
+    return capture.read(frame);
+}
+
+void CameraSource::release() {
+    capture.release();
+}
+
+double CameraSource::getFps() const {
+    return fps;
+}
+
+QString CameraSource::getName() const {
+    return QString("camera %1").arg(device);
+}
+
+/*
+ * Set webcam to run with the best possible resolution (up to 8K UHD)
+ */
+bool CameraSource::useMaxResolution() {
+    if (!capture.isOpened()) {
+        return false;
+    }
+
+    double initWidth = capture.get(cv::CAP_PROP_FRAME_WIDTH);
+    double initHeight = capture.get(cv::CAP_PROP_FRAME_HEIGHT);
+
+    // Set webcam resolution to hightest <= set value
+    bool isResSet = capture.set(cv::CAP_PROP_FRAME_WIDTH, 7680) & capture.set(cv::CAP_PROP_FRAME_HEIGHT, 4320);
+
+    // Set resolution back to previous resolution
+    if (!isResSet) {
+        capture.set(cv::CAP_PROP_FRAME_WIDTH, initWidth);
+        capture.set(cv::CAP_PROP_FRAME_HEIGHT, initHeight);
+    }
+
+    return isResSet;
+}
@@ -0,0 +1,41 @@
+#ifndef CAMERASOURCE_H
+#define CAMERASOURCE_H
+
+// Parent class
+#include "framesource.h"
+
+// Implementation classes
+#include <opencv2/videoio.hpp>
+
+/*
+ * Webcam opened by index, at its best resolution
+ */
+class CameraSource : public FrameSource {
+
+private:
+    int device;
+    cv::VideoCapture capture;
+    double fps = 0;
+    // Resolution the webcam was set to when first opened (empty until then)
+    cv::Size resolution;
+
+    bool useMaxResolution();
+
+public:
+    // Frames read and discarded when opening (the first frames are often slow or badly exposed)
+    static const int WARMUP_FRAMES = 5;
+    // Frames discarded when reopening, since the webcam is already set up
+    static const int RESUME_WARMUP_FRAMES = 2;
+
+    CameraSource(int device);
+
+    int getDevice() const;
+    bool open();
+    bool isOpened() const;
+    bool read(cv::Mat & frame);
+    void release();
+    double getFps() const;
+    QString getName() const;
+};
+
+#endif // CAMERASOURCE_H
@@ -0,0 +1,104 @@
+#include "captureopener.h"
+
+CaptureOpener::CaptureOpener(QObject * parent)
+    : QThread(parent) {
+}
+
+/*
+ * Start opening source, discarding any source opened (or being opened) that wasn't taken yet
+ */
+void CaptureOpener::open(cv::Ptr<FrameSource> source) {
+    mutex.lock();
+    pendingSource = source;
+    openedSource.release();
+    hasResult = false;
+    requested.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+}
+
+/*
+ * Whether a source was requested and hasn't been taken yet
+ */
+bool CaptureOpener::isOpening() {
+    mutex.lock();
+    bool isOpening = (!pendingSource.empty() || hasResult);
+    mutex.unlock();
+
+    return isOpening;
+}
+
+/*
+ * Take the last source that finished opening, if any. The source is empty if it couldn't be opened
+ */
+bool CaptureOpener::takeSource(cv::Ptr<FrameSource> & source) {
+    mutex.lock();
+    bool isTaken = hasResult;
+    if (hasResult) {
+        source = openedSource;
+        openedSource.release();
+        hasResult = false;
+    }
+    mutex.unlock();
+
+    return isTaken;
+}
+
+/*
+ * Block until a source finishes opening or the time runs out. Returns whether one is ready to be taken
+ */
+bool CaptureOpener::waitForSource(unsigned long ms) {
+    mutex.lock();
+    if (!hasResult) {
+        finished.wait(&mutex, ms);
+    }
+    bool isReady = hasResult;
+    mutex.unlock();
+
+    return isReady;
+}
+
+/*
+ * Wait for requests, then open each source
+ */
+void CaptureOpener::run() {
+    forever {
+        mutex.lock();
+        while (pendingSource.empty() && !stopping) {
+            requested.wait(&mutex);
+        }
+        if (stopping) {
+            mutex.unlock();
+            break;
+        }
+        cv::Ptr<FrameSource> source = pendingSource;
+        mutex.unlock();
+
+        TRACE_SCOPE("Source open");
+        bool isOpened = source->open();
+
+        mutex.lock();
+        // Keep the result only if no other source was requested in the meantime
+        if (pendingSource == source) {
+            pendingSource.release();
+            openedSource = isOpened ? source : cv::Ptr<FrameSource>();
+            hasResult = true;
+            finished.wakeAll();
+        }
+        mutex.unlock();
+    }
+}
+
+CaptureOpener::~CaptureOpener() {
+    mutex.lock();
+    stopping = true;
+    requested.wakeAll();
+    finished.wakeAll();
+    mutex.unlock();
+
+    // Stop running thread
+    wait();
+}
@@ -0,0 +1,48 @@
+#ifndef CAPTUREOPENER_H
+#define CAPTUREOPENER_H
+
+// Parent class
+#include <QThread>
+
+// Implementation classes
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <opencv2/core.hpp>
+
+#include "framesource.h"
+#include "tracer.h"
+
+/*
+ * Opens frame sources in the background, separately from the one being played. Webcams take seconds to
+ * reach their best resolution and warm up, so the new source is only handed over once it's ready, and the
+ * player can switch sources between two frames. Only the latest requested source matters
+ */
+class CaptureOpener : public QThread {
+    Q_OBJECT
+
+private:
+    QMutex mutex;
+    QWaitCondition requested;
+    QWaitCondition finished;
+    cv::Ptr<FrameSource> pendingSource;
+    bool stopping = false;
+
+    // Result of the last open (an empty source if it failed)
+    cv::Ptr<FrameSource> openedSource;
+    bool hasResult = false;
+
+protected:
+    void run();
+
+public:
+    CaptureOpener(QObject * parent = nullptr);
+    ~CaptureOpener();
+
+    void open(cv::Ptr<FrameSource> source);
+    bool isOpening();
+    bool takeSource(cv::Ptr<FrameSource> & source);
+    bool waitForSource(unsigned long ms);
+};
+
+#endif // CAPTUREOPENER_H
@@ -0,0 +1,189 @@
+#include "deviceregistry.h"
+
+/*
+ * Registry shared by the whole application (starts enumerating the first time)
+ */
+DeviceRegistry * DeviceRegistry::instance() {
+    static DeviceRegistry * registry = nullptr;
+    if (registry == nullptr) {
+        registry = new DeviceRegistry(QCoreApplication::instance());
+        registry->refresh();
+    }
+
+    return registry;
+}
+
+DeviceRegistry::DeviceRegistry(QObject * parent)
+    : QThread(parent) {
+    // Events arrive in bursts (several nodes per webcam), so enumerate once they stop
+    hotplugTimer.setSingleShot(true);
+    hotplugTimer.setInterval(HOTPLUG_DELAY_MS);
+    connect(&hotplugTimer, SIGNAL (timeout()), this, SLOT (refresh()));
+
+#ifdef Q_OS_LINUX
+    watcher.addPath("/dev");
+    connect(&watcher, SIGNAL (directoryChanged(QString)), &hotplugTimer, SLOT (start()));
+#endif
+}
+
+/*
+ * Enumerate devices in the background. Changes are signalled by devicesChanged()
+ */
+void DeviceRegistry::refresh() {
+    mutex.lock();
+    hasPending = true;
+    requested.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+}
+
+/*
+ * Whether the devices have been enumerated at least once
+ */
+bool DeviceRegistry::isReady() {
+    mutex.lock();
+    bool isReady = ready;
+    mutex.unlock();
+
+    return isReady;
+}
+
+/*
+ * Devices found by the last enumeration (empty until the first one finishes)
+ */
+QList<DeviceRegistry::Device> DeviceRegistry::getDevices() {
+    mutex.lock();
+    QList<Device> curDevices = devices;
+    mutex.unlock();
+
+    return curDevices;
+}
+
+/*
+ * Identity of the system's default webcam (the first one if there is no default)
+ */
+QString DeviceRegistry::getDefaultId() {
+    mutex.lock();
+    QString id = defaultId;
+    mutex.unlock();
+
+    return id;
+}
+
+/*
+ * Index to open a device with, or -1 if it isn't connected
+ */
+int DeviceRegistry::findIndex(const QString & id) {
+    mutex.lock();
+    int index = -1;
+    for (const Device & device : devices) {
+        if (device.id == id) {
+            index = device.index;
+            break;
+        }
+    }
+    mutex.unlock();
+
+    return index;
+}
+
+/*
+ * Wait for requests and enumerate devices (can take seconds with some drivers)
+ */
+void DeviceRegistry::run() {
+#ifdef Q_OS_WIN
+    // DirectShow & Media Foundation need COM on the thread that enumerates, which QThread doesn't set up
+    HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+
+    forever {
+        mutex.lock();
+        while (!hasPending && !stopping) {
+            requested.wait(&mutex);
+        }
+        if (stopping) {
+            mutex.unlock();
+            break;
+        }
+        hasPending = false;
+        mutex.unlock();
+
+        QString newDefaultId;
+        QList<Device> newDevices = enumerate(newDefaultId);
+
+        mutex.lock();
+        devices = newDevices;
+        defaultId = newDefaultId;
+        ready = true;
+        mutex.unlock();
+
+        emit devicesChanged();
+    }
+
+#ifdef Q_OS_WIN
+    if (SUCCEEDED(comResult)) {
+        CoUninitialize();
+    }
+#endif
+}
+
+/*
+ * List connected webcams in the order they are opened by index
+ */
+QList<DeviceRegistry::Device> DeviceRegistry::enumerate(QString & defaultId) {
+    QList<Device> found;
+    QList<QCameraInfo> cameras = QCameraInfo::availableCameras();
+    QCameraInfo defaultCamera = QCameraInfo::defaultCamera();
+
+    // V4L2 devices are opened by the number of their node (/dev/videoN), other systems by enumeration order
+    QRegularExpression nodePattern("^/dev/video(\\d+)$");
+
+    for (int i = 0; i < cameras.count(); i++) {
+        Device device;
+        device.name = cameras[i].description();
+        device.id = device.name + "@" + getBusPath(cameras[i]);
+
+        QRegularExpressionMatch match = nodePattern.match(cameras[i].deviceName());
+        device.index = match.hasMatch() ? match.captured(1).toInt() : i;
+
+        if (cameras[i] == defaultCamera) {
+            defaultId = device.id;
+        }
+        found << device;
+    }
+
+    if (defaultId.isEmpty() && !found.isEmpty()) {
+        defaultId = found.first().id;
+    }
+
+    return found;
+}
+
+/*
+ * Where the device is plugged in. For V4L2 devices this is the sysfs path of the device (e.g. its USB port),
+ * since node numbers are handed out in the order devices appear; otherwise the system's device path is used
+ */
+QString DeviceRegistry::getBusPath(const QCameraInfo & camera) {
+#ifdef Q_OS_LINUX
+    QString node = QFileInfo(camera.deviceName()).fileName();
+    QString busPath = QFileInfo("/sys/class/video4linux/" + node + "/device").canonicalFilePath();
+    if (!busPath.isEmpty()) {
+        return busPath;
+    }
+#endif
+
+    return camera.deviceName();
+}
+
+DeviceRegistry::~DeviceRegistry() {
+    mutex.lock();
+    stopping = true;
+    requested.wakeAll();
+    mutex.unlock();
+
+    // Stop running thread
+    wait();
+}
@@ -0,0 +1,82 @@
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+// Parent class
+#include <QThread>
+
+// Implementation classes
+#include <QCameraInfo>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QList>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QString>
+#include <QTimer>
+#include <QWaitCondition>
+
+#ifdef Q_OS_WIN
+#include <objbase.h>
+#endif
+
+/*
+ * Webcams that are connected, enumerated in the background so that nothing waits for the camera drivers.
+ * Each webcam has a stable identity (its name and where it's plugged in), mapped to the index used to open it,
+ * which can change whenever webcams are plugged in or out. On Linux, V4L2 devices being added or removed
+ * under /dev trigger a new enumeration; other systems only enumerate again when refresh() is called
+ */
+class DeviceRegistry : public QThread {
+    Q_OBJECT
+
+public:
+    struct Device {
+        // Name and bus path, which stay the same across reconnections and reboots
+        QString id;
+        // Name shown to users
+        QString name;
+        // Index to open the device with
+        int index;
+    };
+
+private:
+    QMutex mutex;
+    QWaitCondition requested;
+    bool hasPending = false;
+    bool stopping = false;
+    bool ready = false;
+    QList<Device> devices;
+    QString defaultId;
+
+    QFileSystemWatcher watcher;
+    QTimer hotplugTimer;
+
+    DeviceRegistry(QObject * parent = nullptr);
+    ~DeviceRegistry();
+
+    static QList<Device> enumerate(QString & defaultId);
+    static QString getBusPath(const QCameraInfo & camera);
+
+protected:
+    void run();
+
+public:
+    // Time to wait for device nodes to settle after a hotplug event, before enumerating
+    static const int HOTPLUG_DELAY_MS = 500;
+
+    static DeviceRegistry * instance();
+
+    bool isReady();
+    QList<Device> getDevices();
+    QString getDefaultId();
+    int findIndex(const QString & id);
+
+public slots:
+    void refresh();
+
+signals:
+    // Emitted from the registry's thread each time an enumeration finishes
+    void devicesChanged();
+};
+
+#endif // DEVICEREGISTRY_H
@@ -0,0 +1,156 @@
+#include "documentwriter.h"
+
+PageEncoder::PageEncoder(DocumentWriter * writer, int index, const cv::Mat & snapshot, const ImageSettings & settings)
+    : writer(writer), index(index), snapshot(snapshot), settings(settings) {
+}
+
+/*
+ * Process the snapshot with the settings it was taken with, then hand it back to be written in order
+ */
+void PageEncoder::run() {
+    TRACE_SCOPE("Encode document page");
+
+    cv::Mat processed = ImagePipeline::processImage(snapshot, settings);
+    snapshot.release();
+
+    // Black & white pages stay packed, so they are also stored in the file at 1 bit per pixel
+    QImage page;
+    if (!processed.empty()) {
+        page = WebcamPlayer::convertMatToQImage(processed, settings.isBinary());
+    }
+
+    writer->pageEncoded(index, page);
+}
+
+DocumentWriter::DocumentWriter(const QString & path, QObject * parent)
+    : QThread(parent) {
+    this->path = path;
+
+    // Leave cores for the video & the UI
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+/*
+ * Append a snapshot (which mustn't be modified afterwards) as the next page, processed in the background
+ */
+void DocumentWriter::addPage(const cv::Mat & snapshot, const ImageSettings & settings) {
+    if (snapshot.empty()) {
+        return;
+    }
+
+    mutex.lock();
+    if (finishing) {
+        mutex.unlock();
+        return;
+    }
+    int index = pagesAdded++;
+    mutex.unlock();
+
+    pool.start(new PageEncoder(this, index, snapshot, settings));
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+}
+
+/*
+ * Stop adding pages. The file is completed once the pages already added are written
+ */
+void DocumentWriter::finish() {
+    mutex.lock();
+    finishing = true;
+    pageReady.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning() && !isFinished()) {
+        start(LowPriority);
+    }
+}
+
+/*
+ * Called from the pool once a page is processed (a null page couldn't be processed, and is left out)
+ */
+void DocumentWriter::pageEncoded(int index, const QImage & page) {
+    mutex.lock();
+    encodedPages.insert(index, page);
+    pageReady.wakeOne();
+    mutex.unlock();
+}
+
+/*
+ * Write pages in order as they become ready, until the document is finished and every page is written.
+ * The file is only created with the first page
+ */
+void DocumentWriter::run() {
+    QPdfWriter * writer = nullptr;
+    QPainter painter;
+    bool isOpen = false;
+    int pageCount = 0;
+
+    forever {
+        mutex.lock();
+        while (!encodedPages.contains(pagesWritten) && !(finishing && pagesWritten == pagesAdded)) {
+            pageReady.wait(&mutex);
+        }
+        if (!encodedPages.contains(pagesWritten)) {
+            mutex.unlock();
+            break;
+        }
+        QImage page = encodedPages.take(pagesWritten);
+        pagesWritten++;
+        mutex.unlock();
+
+        if (page.isNull()) {
+            continue;
+        }
+        pageCount++;
+
+        TRACE_SCOPE("Write document page");
+
+        // Page layout applies from the next page, so the first one is set before painting starts
+        if (writer == nullptr) {
+            writer = new QPdfWriter(path);
+            writer->setCreator("MagniRead");
+            writer->setResolution(RESOLUTION);
+            writer->setPageLayout(getPageLayout(page));
+            isOpen = painter.begin(writer);
+        }
+        else if (isOpen) {
+            writer->setPageLayout(getPageLayout(page));
+            writer->newPage();
+        }
+        if (!isOpen) {
+            continue;
+        }
+
+        // As large as fits within the margins, centred
+        QSize size = page.size().scaled(writer->width(), writer->height(), Qt::KeepAspectRatio);
+        QRect target(QPoint((writer->width() - size.width()) / 2, (writer->height() - size.height()) / 2), size);
+        painter.drawImage(target, page);
+    }
+
+    if (isOpen) {
+        painter.end();
+    }
+    delete writer;
+
+    emit documentWritten(isOpen && pageCount > 0, path, pageCount);
+}
+
+/*
+ * A4 page turned to match the page's shape
+ */
+QPageLayout DocumentWriter::getPageLayout(const QImage & page) {
+    QPageLayout::Orientation orientation = (page.width() > page.height()) ? QPageLayout::Landscape : QPageLayout::Portrait;
+    return QPageLayout(QPageSize(QPageSize::A4), orientation,
+                       QMarginsF(MARGIN_MM, MARGIN_MM, MARGIN_MM, MARGIN_MM), QPageLayout::Millimeter);
+}
+
+DocumentWriter::~DocumentWriter() {
+    // Pages already added are still written
+    pool.waitForDone();
+    finish();
+
+    // Stop running thread
+    wait();
+}
@@ -0,0 +1,87 @@
+#ifndef DOCUMENTWRITER_H
+#define DOCUMENTWRITER_H
+
+// Parent class
+#include <QThread>
+
+// Implementation classes
+#include <QImage>
+#include <QMap>
+#include <QMarginsF>
+#include <QMutex>
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QRunnable>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <opencv2/core.hpp>
+
+#include "imagepipeline.h"
+#include "imagesettings.h"
+#include "tracer.h"
+#include "webcamplayer.h"
+
+class DocumentWriter;
+
+/*
+ * Processes one page of a document at full quality, on the writer's pool
+ */
+class PageEncoder : public QRunnable {
+
+private:
+    DocumentWriter * writer;
+    int index;
+    cv::Mat snapshot;
+    ImageSettings settings;
+
+public:
+    PageEncoder(DocumentWriter * writer, int index, const cv::Mat & snapshot, const ImageSettings & settings);
+
+    void run();
+};
+
+/*
+ * Multi-page PDF made from snapshots as they are taken. Pages are processed in parallel on a small pool,
+ * then written in order by this thread as soon as each is ready, so only the pages still being processed
+ * are held in memory. The file is complete once documentWritten() is emitted
+ */
+class DocumentWriter : public QThread {
+    Q_OBJECT
+
+private:
+    QString path;
+    QThreadPool pool;
+    QMutex mutex;
+    QWaitCondition pageReady;
+    // Processed pages waiting for the ones before them, by page index
+    QMap<int, QImage> encodedPages;
+    int pagesAdded = 0;
+    int pagesWritten = 0;
+    bool finishing = false;
+
+    static QPageLayout getPageLayout(const QImage & page);
+
+protected:
+    void run();
+
+public:
+    // Resolution of the page coordinates (images keep their own resolution in the file)
+    static const int RESOLUTION = 300;
+    static const int MARGIN_MM = 10;
+
+    DocumentWriter(const QString & path, QObject * parent = nullptr);
+    ~DocumentWriter();
+
+    void addPage(const cv::Mat & snapshot, const ImageSettings & settings);
+    void finish();
+    void pageEncoded(int index, const QImage & page);
+
+signals:
+    void documentWritten(bool isWritten, const QString & path, int pageCount);
+};
+
+#endif // DOCUMENTWRITER_H
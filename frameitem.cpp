@@ -0,0 +1,57 @@
+#include "frameitem.h"
+
+FrameItem::FrameItem(QGraphicsItem * parent)
+    : QGraphicsItem(parent) {
+}
+
+/*
+ * Replace the displayed frame. Frames the same size as the last one are drawn over the existing pixmap
+ * instead of allocating a new one
+ */
+void FrameItem::setImage(const QImage & img) {
+    setImage(img, img.size());
+}
+
+/*
+ * Replace the displayed frame with one that is stretched to a different size (e.g. a downscaled preview)
+ */
+void FrameItem::setImage(const QImage & img, QSize displaySize) {
+    if (displaySize != size) {
+        prepareGeometryChange();
+        size = displaySize;
+    }
+
+    // Packed black & white images are only expanded as they are uploaded (a 1 bit pixmap is drawn as a mask)
+    QImage drawn = BinaryImage::expand(img);
+
+    if (!pixmap.isNull() && pixmap.size() == drawn.size()) {
+        QPainter painter(&pixmap);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(0, 0, drawn);
+    }
+    else {
+        pixmap = QPixmap::fromImage(drawn);
+    }
+
+    update();
+}
+
+QSize FrameItem::getSize() const {
+    return size;
+}
+
+QRectF FrameItem::boundingRect() const {
+    return QRectF(QPointF(0, 0), size);
+}
+
+void FrameItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget) {
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    if (pixmap.size() == size) {
+        painter->drawPixmap(0, 0, pixmap);
+    }
+    else {
+        painter->drawPixmap(boundingRect(), pixmap, QRectF(pixmap.rect()));
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef FRAMEITEM_H
+#define FRAMEITEM_H
+
+// Parent class
+#include <QGraphicsItem>
+
+// Implementation classes
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QStyleOptionGraphicsItem>
+
+#include "binaryimage.h"
+
+/*
+ * Draws a video frame at its native resolution. Scaling is left to the view's transform, and the
+ * pixmap is reused for every frame with the same size as the last one
+ */
+class FrameItem : public QGraphicsItem {
+
+private:
+    QPixmap pixmap;
+    // Size the frame is drawn at, in scene coordinates
+    QSize size;
+
+public:
+    FrameItem(QGraphicsItem * parent = nullptr);
+
+    void setImage(const QImage & img);
+    void setImage(const QImage & img, QSize displaySize);
+    QSize getSize() const;
+    QRectF boundingRect() const;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr);
+};
+
+#endif // FRAMEITEM_H
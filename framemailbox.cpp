@@ -0,0 +1,43 @@
+#include "framemailbox.h"
+
+/*
+ * Leave a frame for the view, with the times it was read and processed at (see PipelineMetrics::now()).
+ * Returns whether a frame that was never taken got replaced
+ */
+bool FrameMailbox::post(const QImage & img, qint64 frameCapturedAt, qint64 frameProcessedAt) {
+    mutex.lock();
+    bool isReplaced = hasFrame;
+    image = img;
+    capturedAt = frameCapturedAt;
+    processedAt = frameProcessedAt;
+    hasFrame = true;
+    mutex.unlock();
+
+    return isReplaced;
+}
+
+/*
+ * Take the latest frame, if there is one that wasn't taken yet
+ */
+bool FrameMailbox::take(QImage & img, qint64 & frameCapturedAt, qint64 & frameProcessedAt) {
+    mutex.lock();
+    bool isTaken = hasFrame;
+    if (hasFrame) {
+        img = image;
+        frameCapturedAt = capturedAt;
+        frameProcessedAt = processedAt;
+        // The view keeps its own copy, so the mailbox doesn't hold on to the frame's memory
+        image = QImage();
+        hasFrame = false;
+    }
+    mutex.unlock();
+
+    return isTaken;
+}
+
+void FrameMailbox::clear() {
+    mutex.lock();
+    image = QImage();
+    hasFrame = false;
+    mutex.unlock();
+}
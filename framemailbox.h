@@ -0,0 +1,27 @@
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+// Implementation classes
+#include <QImage>
+#include <QMutex>
+
+/*
+ * Holds the latest processed video frame until the view presents it. Posting replaces a frame that wasn't
+ * taken yet, so the view always shows the newest frame and never works through a backlog of old ones
+ */
+class FrameMailbox {
+
+private:
+    QMutex mutex;
+    QImage image;
+    qint64 capturedAt = 0;
+    qint64 processedAt = 0;
+    bool hasFrame = false;
+
+public:
+    bool post(const QImage & img, qint64 frameCapturedAt, qint64 frameProcessedAt);
+    bool take(QImage & img, qint64 & frameCapturedAt, qint64 & frameProcessedAt);
+    void clear();
+};
+
+#endif // FRAMEMAILBOX_H
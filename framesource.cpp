@@ -0,0 +1,36 @@
+#include "framesource.h"
+
+FrameSource::FrameSource() {
+}
+
+FrameSource::~FrameSource() {
+}
+
+double FrameSource::getFps() const {
+    return 0;
+}
+
+int FrameSource::getDevice() const {
+    return -1;
+}
+
+/*
+ * Wait until the next frame is due at the given frame rate (no waiting if fps <= 0). Frames are not
+ * sent in a burst to catch up after reading falls behind
+ */
+void FrameSource::pace(double fps) {
+    if (fps <= 0) {
+        return;
+    }
+
+    qint64 interval = qint64(1e9 / fps);
+    qint64 now = PipelineMetrics::now();
+    if (nextFrameTime == 0 || now - nextFrameTime > interval) {
+        nextFrameTime = now;
+    }
+    else if (nextFrameTime > now) {
+        QThread::usleep(ulong((nextFrameTime - now) / 1000));
+    }
+
+    nextFrameTime += interval;
+}
@@ -0,0 +1,42 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+// Implementation classes
+#include <QString>
+#include <QThread>
+
+#include <opencv2/core.hpp>
+
+#include "pipelinemetrics.h"
+
+/*
+ * Where the player reads frames from: a webcam, or a recording or generated page that behaves like one
+ * (so that problems can be reproduced without the webcam). Sources are opened and read on background threads
+ */
+class FrameSource {
+
+private:
+    qint64 nextFrameTime = 0;
+
+protected:
+    void pace(double fps);
+
+public:
+    FrameSource();
+    virtual ~FrameSource();
+
+    // Open the source, ready for the first frame to be read (can take seconds)
+    virtual bool open() = 0;
+    virtual bool isOpened() const = 0;
+    // Read the next frame, waiting for it if necessary. Returns false when no more frames can be read
+    virtual bool read(cv::Mat & frame) = 0;
+    virtual void release() = 0;
+    // Rate that frames arrive at (0 if unknown or as fast as they can be read)
+    virtual double getFps() const;
+    // Index of the device the source reads from (-1 if it isn't a device, which can be opened more than once)
+    virtual int getDevice() const;
+    // Short description of the source, for logs
+    virtual QString getName() const = 0;
+};
+
+#endif // FRAMESOURCE_H
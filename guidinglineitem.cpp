@@ -0,0 +1,56 @@
+#include "guidinglineitem.h"
+
+GuidingLineItem::GuidingLineItem(QGraphicsItem * parent)
+    : OverlayItem(parent) {
+}
+
+/*
+ * Set position of line as fraction of the viewport's height (0 is top, 1 is bottom)
+ */
+void GuidingLineItem::setLinePos(double fraction) {
+    linePos = fraction;
+    updateViewportPos();
+}
+
+void GuidingLineItem::setThickness(int px) {
+    prepareGeometryChange();
+    thickness = px;
+    update();
+}
+
+void GuidingLineItem::setColor(QColor color) {
+    this->color = color;
+    update();
+}
+
+/*
+ * Stretch line across the viewport's width
+ */
+void GuidingLineItem::setViewportSize(QSize size) {
+    if (size.width() != viewportSize.width()) {
+        prepareGeometryChange();
+    }
+    OverlayItem::setViewportSize(size);
+    updateViewportPos();
+}
+
+void GuidingLineItem::updateViewportPos() {
+    setViewportPos(QPointF(0, viewportSize.height() * linePos));
+}
+
+/*
+ * Line centred on the item's origin, with a pixel of margin for antialiasing
+ */
+QRectF GuidingLineItem::boundingRect() const {
+    return QRectF(0, -thickness / 2.0 - 1, viewportSize.width(), thickness + 2);
+}
+
+void GuidingLineItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget) {
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    QPen pen(color, thickness, Qt::SolidLine);
+    painter->setPen(pen);
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->drawLine(QPointF(0, 0), QPointF(viewportSize.width(), 0));
+}
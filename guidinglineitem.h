@@ -0,0 +1,37 @@
+#ifndef GUIDINGLINEITEM_H
+#define GUIDINGLINEITEM_H
+
+// Parent class
+#include "overlayitem.h"
+
+// Implementation classes
+#include <QColor>
+#include <QPainter>
+#include <QPen>
+#include <QStyleOptionGraphicsItem>
+
+/*
+ * Horizontal line across the viewport to guide reading
+ */
+class GuidingLineItem : public OverlayItem {
+
+private:
+    // Fraction of the viewport's height from the top
+    double linePos = 0.5;
+    int thickness = 10;
+    QColor color = Qt::black;
+
+    void updateViewportPos();
+
+public:
+    GuidingLineItem(QGraphicsItem * parent = nullptr);
+
+    void setLinePos(double fraction);
+    void setThickness(int px);
+    void setColor(QColor color);
+    void setViewportSize(QSize size);
+    QRectF boundingRect() const;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr);
+};
+
+#endif // GUIDINGLINEITEM_H
@@ -0,0 +1,239 @@
+#include "imagepipeline.h"
+
+ImagePipeline::ImagePipeline() {
+}
+
+/*
+ * Replace the image to be processed, discarding every cached stage
+ */
+void ImagePipeline::setSource(const cv::Mat & img) {
+    source = img;
+    coverage.release();
+    for (CachedStage & stage : stages) {
+        stage = CachedStage();
+    }
+}
+
+cv::Mat ImagePipeline::getSource() const {
+    return source;
+}
+
+bool ImagePipeline::hasSource() const {
+    return !source.empty();
+}
+
+/*
+ * Process source image, reusing the output of every stage whose parameters (and earlier stages) didn't change.
+ * Returns an empty image if cancelled between stages
+ */
+cv::Mat ImagePipeline::process(const ImageSettings & settings, const std::function<bool()> & isCancelled) {
+    if (source.empty()) {
+        return cv::Mat();
+    }
+
+    bool isInputChanged = false;
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        Stage stage = Stage(i);
+        CachedStage & cached = stages[stage];
+        if (cached.isValid && !isStageChanged(stage, cached.settings, settings) && !isInputChanged) {
+            continue;
+        }
+
+        if (isCancelled && isCancelled()) {
+            return cv::Mat();
+        }
+
+        switch (stage) {
+            case GEOMETRY : {
+                cv::Mat scaled = scale(source, settings.scale);
+                cached.output = rotate(scaled, settings.angle, settings.interpolation);
+                coverage = getCoverage(scaled.size(), settings.angle, settings.interpolation);
+                break;
+            }
+            case TONE :
+                cached.output = adjustTone(stages[GEOMETRY].output, coverage, settings.contrast, settings.brightness);
+                break;
+            case FILTER :
+            default:
+                cached.output = applyFilter(stages[TONE].output, settings.filter);
+                break;
+        }
+        cached.settings = settings;
+        cached.isValid = true;
+        isInputChanged = true;
+    }
+
+    return stages[FILTER].output;
+}
+
+/*
+ * Process image through every stage without caching, recording how long each stage takes if metrics are given
+ */
+cv::Mat ImagePipeline::processImage(const cv::Mat & img, const ImageSettings & settings, PipelineMetrics * metrics) {
+    qint64 startTime = (metrics != nullptr) ? PipelineMetrics::now() : 0;
+
+    cv::Mat scaled = scale(img, settings.scale);
+    qint64 scaledTime = (metrics != nullptr) ? PipelineMetrics::now() : 0;
+
+    // Tone first, so that a single warp rotates the frame and the corners it uncovers stay black
+    cv::Mat adjusted = adjustTone(scaled, cv::Mat(), settings.contrast, settings.brightness);
+    qint64 adjustedTime = (metrics != nullptr) ? PipelineMetrics::now() : 0;
+
+    cv::Mat rotated = rotate(adjusted, settings.angle, settings.interpolation);
+    qint64 rotatedTime = (metrics != nullptr) ? PipelineMetrics::now() : 0;
+
+    cv::Mat filtered = applyFilter(rotated, settings.filter);
+
+    if (metrics != nullptr) {
+        if (settings.scale < 1) {
+            metrics->record(PipelineMetrics::SCALE, scaledTime - startTime);
+        }
+        metrics->record(PipelineMetrics::ADJUST, adjustedTime - scaledTime);
+        metrics->record(PipelineMetrics::ROTATE, rotatedTime - adjustedTime);
+        metrics->record(PipelineMetrics::FILTER, PipelineMetrics::now() - rotatedTime);
+    }
+
+    return filtered;
+}
+
+/*
+ * Downscale by a factor (no copy if the factor is 1 or more)
+ */
+cv::Mat ImagePipeline::scale(const cv::Mat & img, double factor) {
+    if (factor >= 1) {
+        return img;
+    }
+
+    TRACE_SCOPE("Scale");
+    cv::Mat scaled;
+    cv::resize(img, scaled, cv::Size(), factor, factor, cv::INTER_AREA);
+
+    return scaled;
+}
+
+/*
+ * Rotate clockwise by the specified amount of degrees, enlarging the image to fit all of it
+ */
+cv::Mat ImagePipeline::rotate(const cv::Mat & img, int angle, int interpolation) {
+    TRACE_SCOPE("Rotate");
+
+    if (angle % 360 == 0) {
+        return img;
+    }
+
+    cv::Size rotatedSize;
+    cv::Mat rotMatrix = getRotationMatrix(img.size(), angle, rotatedSize);
+
+    cv::Mat rotated;
+    cv::warpAffine(img, rotated, rotMatrix, rotatedSize, interpolation);
+
+    return rotated;
+}
+
+/*
+ * How much of each pixel of an image of the given size, once rotated, came from the image (0 to 255, single channel).
+ * Empty if not rotated, since all of it is covered
+ */
+cv::Mat ImagePipeline::getCoverage(cv::Size size, int angle, int interpolation) {
+    if (angle % 360 == 0) {
+        return cv::Mat();
+    }
+
+    cv::Size rotatedSize;
+    cv::Mat rotMatrix = getRotationMatrix(size, angle, rotatedSize);
+
+    cv::Mat coverage;
+    cv::warpAffine(cv::Mat(size, CV_8UC1, cv::Scalar(255)), coverage, rotMatrix, rotatedSize, interpolation);
+
+    return coverage;
+}
+
+/*
+ * Transformation that rotates an image of the given size clockwise, and the size that fits all of it
+ */
+cv::Mat ImagePipeline::getRotationMatrix(cv::Size size, int angle, cv::Size & rotatedSize) {
+    cv::Point2f frameCenter(size.width/2.0F, size.height/2.0F);
+    cv::Mat rotMatrix = cv::getRotationMatrix2D(frameCenter, -angle, 1.0);
+    // Determine bounding rectangle
+    cv::Rect2f boundsBox = cv::RotatedRect(cv::Point2f(), size, -angle).boundingRect2f();
+    // Adjust transformation matrix to fit full image
+    rotMatrix.at<double>(0,2) += boundsBox.width/2.0 - size.width/2.0;
+    rotMatrix.at<double>(1,2) += boundsBox.height/2.0 - size.height/2.0;
+
+    rotatedSize = boundsBox.size();
+    return rotMatrix;
+}
+
+/*
+ * image' = contrast * image + brightness (only as much brightness as the pixel is covered by the image,
+ * if coverage is given)
+ */
+cv::Mat ImagePipeline::adjustTone(const cv::Mat & img, const cv::Mat & coverage, double contrast, double brightness) {
+    TRACE_SCOPE("Adjust tone");
+
+    cv::Mat adjusted;
+    if (coverage.empty()) {
+        img.convertTo(adjusted, -1, contrast, brightness);
+    }
+    else {
+        // Same coverage for every channel
+        cv::Mat channelCoverage = coverage;
+        if (img.channels() > 1) {
+            cv::merge(std::vector<cv::Mat>(size_t(img.channels()), coverage), channelCoverage);
+        }
+        cv::addWeighted(img, contrast, channelCoverage, brightness / 255, 0, adjusted);
+    }
+
+    return adjusted;
+}
+
+/*
+ * Convert colors depending on filter string
+ */
+cv::Mat ImagePipeline::applyFilter(const cv::Mat & img, const std::string & filter) {
+    TRACE_SCOPE("Filter");
+
+    if (img.channels() != 3) {
+        return img;
+    }
+
+    if (filter == "Greyscale" || filter == "Grayscale") {
+        cv::Mat greyFrame;
+
+        // Convert BGR to single color channel (CV_8UC3 -> CV_8UC1)
+        cv::cvtColor(img, greyFrame, CV_BGR2GRAY);
+
+        return greyFrame;
+    }
+    else if (filter == "Black and White") {
+        cv::Mat monoFrame;
+
+        // Convert BGR to single color channel (CV_8UC3 -> CV_8UC1)
+        cv::cvtColor(img, monoFrame, CV_BGR2GRAY);
+        // Make any pixel >= 100 white, else black (changing brightness/contrast affects this threshhold)
+        cv::threshold(monoFrame, monoFrame, 100, 255, cv::THRESH_BINARY );
+
+        return monoFrame;
+    }
+    else { // filter == "None"
+
+        return img;
+    }
+}
+
+/*
+ * Whether any setting a stage depends on differs from the ones its output was made with
+ * (earlier stages are checked separately)
+ */
+bool ImagePipeline::isStageChanged(Stage stage, const ImageSettings & cached, const ImageSettings & settings) {
+    switch (stage) {
+        case GEOMETRY :
+            return cached.scale != settings.scale || cached.interpolation != settings.interpolation
+                    || cached.angle % 360 != settings.angle % 360;
+        case TONE :
+            return cached.contrast != settings.contrast || cached.brightness != settings.brightness;
+        case FILTER :
+        default:
+            return cached.filter != settings.filter;
+    }
+}
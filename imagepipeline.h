@@ -0,0 +1,67 @@
+#ifndef IMAGEPIPELINE_H
+#define IMAGEPIPELINE_H
+
+// Implementation classes
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "imagesettings.h"
+#include "pipelinemetrics.h"
+#include "tracer.h"
+
+/*
+ * Image processing for video frames (processImage(), in one pass) and for snapshots (an instance).
+ * An instance keeps a source image and the output of each stage: geometry (scale & rotation), tone
+ * (contrast & brightness), then filter, with the settings each was made with, so that changing a setting
+ * only recomputes the stages that depend on it and the ones after it.
+ *
+ * Video frames have their tone adjusted before they are rotated. Cached stages rotate first instead, so that
+ * tone changes don't rotate again, and keep the corners that rotation uncovers black by weighting brightness
+ * with the coverage of each pixel (worked out once per rotation). Snapshots therefore differ from video frames
+ * wherever rotation blends pixels that contrast & brightness saturate, such as around dark text on bright paper
+ */
+class ImagePipeline {
+
+public:
+    enum Stage : int {
+        GEOMETRY = 0,
+        TONE = 1,
+        FILTER = 2,
+        STAGE_COUNT = 3,
+    };
+
+    ImagePipeline();
+
+    void setSource(const cv::Mat & img);
+    cv::Mat getSource() const;
+    bool hasSource() const;
+    cv::Mat process(const ImageSettings & settings, const std::function<bool()> & isCancelled = nullptr);
+
+    static cv::Mat processImage(const cv::Mat & img, const ImageSettings & settings, PipelineMetrics * metrics = nullptr);
+    static cv::Mat scale(const cv::Mat & img, double factor);
+    static cv::Mat rotate(const cv::Mat & img, int angle, int interpolation = cv::INTER_LINEAR);
+    static cv::Mat getCoverage(cv::Size size, int angle, int interpolation = cv::INTER_LINEAR);
+    static cv::Mat adjustTone(const cv::Mat & img, const cv::Mat & coverage, double contrast, double brightness);
+    static cv::Mat applyFilter(const cv::Mat & img, const std::string & filter);
+
+private:
+    struct CachedStage {
+        ImageSettings settings;
+        bool isValid = false;
+        cv::Mat output;
+    };
+
+    cv::Mat source;
+    // Fraction of each rotated pixel that came from the source image, single channel (empty if not rotated)
+    cv::Mat coverage;
+    CachedStage stages[STAGE_COUNT];
+
+    static cv::Mat getRotationMatrix(cv::Size size, int angle, cv::Size & rotatedSize);
+    static bool isStageChanged(Stage stage, const ImageSettings & cached, const ImageSettings & settings);
+};
+
+#endif // IMAGEPIPELINE_H
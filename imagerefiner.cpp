@@ -0,0 +1,115 @@
+#include "imagerefiner.h"
+
+ImageRefiner::ImageRefiner(QObject * parent)
+    : QThread(parent) {
+}
+
+/*
+ * Resample region of the image (in image pixels) to the target size (in screen pixels)
+ */
+void ImageRefiner::refine(const QImage & img, QRect region, QSize targetSize, int requestId) {
+    mutex.lock();
+    pending.image = img;
+    pending.region = region;
+    pending.targetSize = targetSize;
+    pending.id = requestId;
+    hasPending = true;
+    requested.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+}
+
+/*
+ * Get the last resampled region. Returns false if there is nothing new
+ */
+bool ImageRefiner::takeResult(QImage & img, QRect & region, int & requestId) {
+    mutex.lock();
+    bool hasResult = !result.isNull();
+    img = result;
+    region = resultRegion;
+    requestId = resultId;
+    result = QImage();
+    mutex.unlock();
+
+    return hasResult;
+}
+
+/*
+ * Wait for requests and resample the latest one
+ */
+void ImageRefiner::run() {
+    forever {
+        mutex.lock();
+        while (!hasPending && !stopping) {
+            requested.wait(&mutex);
+        }
+        if (stopping) {
+            mutex.unlock();
+            break;
+        }
+        Request request = pending;
+        pending = Request();
+        hasPending = false;
+        mutex.unlock();
+
+        QImage resampled = resample(request.image, request.region, request.targetSize);
+
+        mutex.lock();
+        // Drop result if a newer request arrived while resampling
+        bool isStale = hasPending;
+        if (!isStale) {
+            result = resampled;
+            resultRegion = request.region;
+            resultId = request.id;
+        }
+        mutex.unlock();
+
+        if (!isStale && !resampled.isNull()) {
+            emit refined();
+        }
+    }
+}
+
+/*
+ * Lanczos interpolation when enlarging (sharp text edges), pixel area averaging when shrinking (no aliasing)
+ */
+QImage ImageRefiner::resample(const QImage & img, QRect region, QSize targetSize) {
+    QImage source = TilePyramid::normalizeFormat(img);
+    region &= source.rect();
+    if (region.isEmpty() || targetSize.isEmpty()) {
+        return QImage();
+    }
+
+    // Only the visible part of a packed black & white image is unpacked, and it's resampled in grey
+    QImage::Format format = source.format();
+    int type = (source.depth() == 32) ? CV_8UC4 : (source.depth() == 24) ? CV_8UC3 : CV_8UC1;
+    cv::Mat srcRegion;
+    if (format == QImage::Format_Mono) {
+        srcRegion = BinaryImage::unpack(source, region);
+        format = QImage::Format_Grayscale8;
+    }
+    else {
+        cv::Mat src(source.height(), source.width(), type, const_cast<uchar *>(source.constBits()), size_t(source.bytesPerLine()));
+        srcRegion = src(cv::Rect(region.x(), region.y(), region.width(), region.height()));
+    }
+
+    QImage resampled(targetSize, format);
+    cv::Mat dst(resampled.height(), resampled.width(), type, resampled.bits(), size_t(resampled.bytesPerLine()));
+    int interpolation = (targetSize.width() > region.width()) ? cv::INTER_LANCZOS4 : cv::INTER_AREA;
+    cv::resize(srcRegion, dst, dst.size(), 0, 0, interpolation);
+
+    return resampled;
+}
+
+ImageRefiner::~ImageRefiner() {
+    mutex.lock();
+    stopping = true;
+    requested.wakeAll();
+    mutex.unlock();
+
+    // Stop running thread
+    wait();
+}
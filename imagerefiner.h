@@ -0,0 +1,60 @@
+#ifndef IMAGEREFINER_H
+#define IMAGEREFINER_H
+
+// Parent class
+#include <QThread>
+
+// Implementation classes
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QWaitCondition>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "tilepyramid.h"
+
+/*
+ * Resamples part of an image with high quality interpolation in the background. Only the latest
+ * request matters: a new request replaces one that hasn't started, and the result of an older one is dropped
+ */
+class ImageRefiner : public QThread {
+    Q_OBJECT
+
+private:
+    struct Request {
+        QImage image;
+        QRect region;
+        QSize targetSize;
+        int id = 0;
+    };
+
+    QMutex mutex;
+    QWaitCondition requested;
+    Request pending;
+    bool hasPending = false;
+    bool stopping = false;
+
+    QImage result;
+    QRect resultRegion;
+    int resultId = 0;
+
+    static QImage resample(const QImage & img, QRect region, QSize targetSize);
+
+protected:
+    void run();
+
+public:
+    ImageRefiner(QObject * parent = nullptr);
+    ~ImageRefiner();
+
+    void refine(const QImage & img, QRect region, QSize targetSize, int requestId);
+    bool takeResult(QImage & img, QRect & region, int & requestId);
+
+signals:
+    void refined();
+};
+
+#endif // IMAGEREFINER_H
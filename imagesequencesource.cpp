@@ -0,0 +1,50 @@
+#include "imagesequencesource.h"
+
+ImageSequenceSource::ImageSequenceSource(const QString & dirPath, double fps) {
+    this->dirPath = dirPath;
+    this->fps = fps;
+}
+
+bool ImageSequenceSource::open() {
+    QDir dir(dirPath);
+    QStringList nameFilters = {"*.png", "*.jpg", "*.jpeg", "*.bmp", "*.tif", "*.tiff"};
+
+    files.clear();
+    for (const QString & fileName : dir.entryList(nameFilters, QDir::Files, QDir::Name)) {
+        files << dir.filePath(fileName);
+    }
+    nextFile = 0;
+
+    return !files.isEmpty();
+}
+
+bool ImageSequenceSource::isOpened() const {
+    return !files.isEmpty();
+}
+
+/*
+ * Read the next image (each one is read from disk again, like a camera would deliver a new frame)
+ */
+bool ImageSequenceSource::read(cv::Mat & frame) {
+    if (files.isEmpty()) {
+        return false;
+    }
+
+    pace(fps);
+    frame = cv::imread(files[nextFile].toStdString(), cv::IMREAD_COLOR);
+    nextFile = (nextFile + 1) % files.count();
+
+    return !frame.empty();
+}
+
+void ImageSequenceSource::release() {
+    files.clear();
+}
+
+double ImageSequenceSource::getFps() const {
+    return fps;
+}
+
+QString ImageSequenceSource::getName() const {
+    return QString("images %1").arg(dirPath);
+}
@@ -0,0 +1,35 @@
+#ifndef IMAGESEQUENCESOURCE_H
+#define IMAGESEQUENCESOURCE_H
+
+// Parent class
+#include "framesource.h"
+
+// Implementation classes
+#include <QDir>
+#include <QStringList>
+
+#include <opencv2/imgcodecs.hpp>
+
+/*
+ * Images in a directory played as frames in file name order, starting over after the last one
+ */
+class ImageSequenceSource : public FrameSource {
+
+private:
+    QString dirPath;
+    double fps;
+    QStringList files;
+    int nextFile = 0;
+
+public:
+    ImageSequenceSource(const QString & dirPath, double fps);
+
+    bool open();
+    bool isOpened() const;
+    bool read(cv::Mat & frame);
+    void release();
+    double getFps() const;
+    QString getName() const;
+};
+
+#endif // IMAGESEQUENCESOURCE_H
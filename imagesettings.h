@@ -0,0 +1,37 @@
+#ifndef IMAGESETTINGS_H
+#define IMAGESETTINGS_H
+
+// Implementation classes
+#include <string>
+
+#include <opencv2/imgproc.hpp>
+
+/*
+ * Values that control how an image is processed, copied as a whole so that another thread
+ * can process an image while the settings keep changing
+ */
+struct ImageSettings {
+    double contrast = 1; // "Alpha" value as scaling factor (multiplication)
+    double brightness = 0; // "Beta" value as image delta (addition)
+    std::string filter = "None"; // Image filter to be applied
+    int angle = 0; // Clockwise rotation in degrees
+    double scale = 1; // Fraction of the resolution the image is processed at (lowered to keep up with the webcam)
+    int interpolation = cv::INTER_LINEAR; // Resampling used for rotation
+
+    bool operator==(const ImageSettings & other) const {
+        return contrast == other.contrast && brightness == other.brightness
+                && filter == other.filter && angle == other.angle
+                && scale == other.scale && interpolation == other.interpolation;
+    }
+
+    bool operator!=(const ImageSettings & other) const {
+        return !(*this == other);
+    }
+
+    // Whether the filter leaves only black & white pixels (which are stored packed, see BinaryImage)
+    bool isBinary() const {
+        return filter == "Black and White";
+    }
+};
+
+#endif // IMAGESETTINGS_H
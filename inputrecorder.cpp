@@ -0,0 +1,112 @@
+#include "inputrecorder.h"
+
+/*
+ * Start recording input over the viewport (sliders & buttons are added with watchSlider() & watchButton())
+ */
+InputRecorder::InputRecorder(const QString & path, QWidget * viewport, QObject * parent)
+    : QObject(parent) {
+    this->path = path;
+    this->viewport = viewport;
+
+    viewport->installEventFilter(this);
+    clock.start();
+}
+
+void InputRecorder::watchSlider(const QString & name, QAbstractSlider * slider) {
+    names[slider] = name;
+    connect(slider, SIGNAL (valueChanged(int)), this, SLOT (recordSlider(int)));
+}
+
+void InputRecorder::watchButton(const QString & name, QAbstractButton * button) {
+    names[button] = name;
+    connect(button, SIGNAL (released()), this, SLOT (recordButton()));
+}
+
+/*
+ * Write the session as JSON
+ */
+bool InputRecorder::save() {
+    QJsonObject session;
+    session["events"] = events;
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+
+    return file.write(QJsonDocument(session).toJson()) >= 0;
+}
+
+/*
+ * Record mouse & wheel events on their way to the viewport (without filtering them out)
+ */
+bool InputRecorder::eventFilter(QObject * watched, QEvent * event) {
+    if (watched != viewport || viewport->width() <= 0 || viewport->height() <= 0) {
+        return false;
+    }
+
+    QJsonObject recorded;
+    switch (event->type()) {
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseMove: {
+            QMouseEvent * mouseEvent = static_cast<QMouseEvent *>(event);
+            recorded["type"] = (event->type() == QEvent::MouseButtonPress) ? "mousePress"
+                             : (event->type() == QEvent::MouseButtonRelease) ? "mouseRelease" : "mouseMove";
+            recorded["x"] = mouseEvent->localPos().x() / viewport->width();
+            recorded["y"] = mouseEvent->localPos().y() / viewport->height();
+            recorded["button"] = int(mouseEvent->button());
+            recorded["buttons"] = int(mouseEvent->buttons());
+            recorded["modifiers"] = int(mouseEvent->modifiers());
+            break;
+        }
+        case QEvent::Wheel: {
+            QWheelEvent * wheelEvent = static_cast<QWheelEvent *>(event);
+            recorded["type"] = "wheel";
+            recorded["x"] = wheelEvent->posF().x() / viewport->width();
+            recorded["y"] = wheelEvent->posF().y() / viewport->height();
+            recorded["angleDeltaX"] = wheelEvent->angleDelta().x();
+            recorded["angleDeltaY"] = wheelEvent->angleDelta().y();
+            recorded["buttons"] = int(wheelEvent->buttons());
+            recorded["modifiers"] = int(wheelEvent->modifiers());
+            break;
+        }
+        default:
+            return false;
+    }
+
+    addEvent(recorded);
+    return false;
+}
+
+void InputRecorder::recordSlider(int value) {
+    QJsonObject recorded;
+    recorded["type"] = "slider";
+    recorded["name"] = names.value(sender());
+    recorded["value"] = value;
+    addEvent(recorded);
+}
+
+void InputRecorder::recordButton() {
+    QJsonObject recorded;
+    recorded["type"] = "button";
+    recorded["name"] = names.value(sender());
+    addEvent(recorded);
+}
+
+/*
+ * Add event at the time since recording started (in milliseconds)
+ */
+void InputRecorder::addEvent(QJsonObject event) {
+    event["time"] = clock.nsecsElapsed() / 1e6;
+    events.append(event);
+}
+
+InputRecorder::~InputRecorder() {
+    if (save()) {
+        qInfo("Input session saved to %s", qUtf8Printable(path));
+    }
+    else {
+        qWarning("Input session could not be saved to %s", qUtf8Printable(path));
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+// Parent class
+#include <QObject>
+
+// Implementation classes
+#include <QAbstractButton>
+#include <QAbstractSlider>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QString>
+#include <QWheelEvent>
+#include <QWidget>
+
+/*
+ * Records a session of input (mouse & wheel over the image, slider values and button clicks) with
+ * the time of each event, so that it can be replayed by InputReplayer. Positions are stored relative
+ * to the viewport size. The session is saved when the recorder is destroyed
+ */
+class InputRecorder : public QObject {
+    Q_OBJECT
+
+private:
+    QString path;
+    QWidget * viewport;
+    QElapsedTimer clock;
+    QJsonArray events;
+    // Names that sliders & buttons are recorded under
+    QHash<QObject *, QString> names;
+
+    void addEvent(QJsonObject event);
+
+private slots:
+    void recordSlider(int value);
+    void recordButton();
+
+protected:
+    bool eventFilter(QObject * watched, QEvent * event);
+
+public:
+    InputRecorder(const QString & path, QWidget * viewport, QObject * parent = nullptr);
+    ~InputRecorder();
+
+    void watchSlider(const QString & name, QAbstractSlider * slider);
+    void watchButton(const QString & name, QAbstractButton * button);
+    bool save();
+};
+
+#endif // INPUTRECORDER_H
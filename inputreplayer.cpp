@@ -0,0 +1,180 @@
+#include "inputreplayer.h"
+
+InputReplayer::InputReplayer(const QString & reportPath, QWidget * viewport, QObject * parent)
+    : QObject(parent) {
+    this->reportPath = reportPath;
+    this->viewport = viewport;
+
+    eventTimer.setSingleShot(true);
+    eventTimer.setTimerType(Qt::PreciseTimer);
+    connect(&eventTimer, SIGNAL (timeout()), this, SLOT (replayDueEvents()));
+}
+
+/*
+ * Read a session saved by InputRecorder
+ */
+bool InputReplayer::load(const QString & path) {
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QJsonDocument session = QJsonDocument::fromJson(file.readAll());
+    if (!session.isObject()) {
+        return false;
+    }
+
+    events = session.object()["events"].toArray();
+    return true;
+}
+
+/*
+ * Sliders & buttons are found by the names they were recorded under
+ */
+void InputReplayer::addSlider(const QString & name, QAbstractSlider * slider) {
+    sliders[name] = slider;
+}
+
+void InputReplayer::addButton(const QString & name, QAbstractButton * button) {
+    buttons[name] = button;
+}
+
+/*
+ * Start replaying from the first event (measurements start now too)
+ */
+void InputReplayer::start() {
+    if (isReplaying) {
+        return;
+    }
+
+    isReplaying = true;
+    nextEvent = 0;
+    frameTimes.reset();
+    inputLatencies.reset();
+    lastPaintTime = 0;
+    unpaintedInputTime = 0;
+
+    clock.start();
+    qInfo("Replaying %d input events", events.count());
+    replayDueEvents();
+}
+
+/*
+ * Replay every event whose time has come, then wait for the next one
+ */
+void InputReplayer::replayDueEvents() {
+    while (nextEvent < events.count()) {
+        QJsonObject event = events[nextEvent].toObject();
+        qint64 dueIn = qint64(event["time"].toDouble()) - clock.elapsed();
+        if (dueIn > 0) {
+            eventTimer.start(int(dueIn));
+            return;
+        }
+
+        replayEvent(event);
+        nextEvent++;
+    }
+
+    QTimer::singleShot(SETTLE_MS, this, SLOT (finish()));
+}
+
+/*
+ * Post a recorded event to the viewport as if it came from the user (or set the slider/click the button)
+ */
+void InputReplayer::replayEvent(const QJsonObject & event) {
+    if (unpaintedInputTime == 0) {
+        unpaintedInputTime = PipelineMetrics::now();
+    }
+
+    QString type = event["type"].toString();
+    QPointF pos(event["x"].toDouble() * viewport->width(), event["y"].toDouble() * viewport->height());
+    QPointF globalPos = viewport->mapToGlobal(pos.toPoint());
+    Qt::MouseButtons mouseButtons = Qt::MouseButtons(event["buttons"].toInt());
+    Qt::KeyboardModifiers modifiers = Qt::KeyboardModifiers(event["modifiers"].toInt());
+
+    if (type == "mousePress" || type == "mouseRelease" || type == "mouseMove") {
+        QEvent::Type eventType = (type == "mousePress") ? QEvent::MouseButtonPress
+                               : (type == "mouseRelease") ? QEvent::MouseButtonRelease : QEvent::MouseMove;
+        Qt::MouseButton button = Qt::MouseButton(event["button"].toInt());
+        QCoreApplication::postEvent(viewport,
+                                    new QMouseEvent(eventType, pos, pos, globalPos, button, mouseButtons, modifiers));
+    }
+    else if (type == "wheel") {
+        QPoint angleDelta(event["angleDeltaX"].toInt(), event["angleDeltaY"].toInt());
+        QCoreApplication::postEvent(viewport,
+                                    new QWheelEvent(pos, globalPos, QPoint(), angleDelta, angleDelta.y(),
+                                                    Qt::Vertical, mouseButtons, modifiers));
+    }
+    else if (type == "slider" && sliders.contains(event["name"].toString())) {
+        sliders[event["name"].toString()]->setValue(event["value"].toInt());
+    }
+    else if (type == "button" && buttons.contains(event["name"].toString())) {
+        buttons[event["name"].toString()]->click();
+    }
+}
+
+/*
+ * Measure the time since the last paint, and the delay since the oldest input that wasn't painted yet
+ */
+void InputReplayer::framePainted() {
+    if (!isReplaying) {
+        return;
+    }
+
+    qint64 now = PipelineMetrics::now();
+    if (lastPaintTime > 0) {
+        frameTimes.record(quint64(now - lastPaintTime) / 1000);
+    }
+    lastPaintTime = now;
+
+    if (unpaintedInputTime > 0) {
+        inputLatencies.record(quint64(now - unpaintedInputTime) / 1000);
+        unpaintedInputTime = 0;
+    }
+}
+
+void InputReplayer::finish() {
+    isReplaying = false;
+    emit finished(writeReport());
+}
+
+/*
+ * Write both distributions as JSON (in milliseconds), and log them
+ */
+bool InputReplayer::writeReport() {
+    QJsonObject report;
+    report["events"] = events.count();
+    report["durationMs"] = double(clock.elapsed());
+    report["frameTimeMs"] = summarize(frameTimes);
+    report["inputToPaintMs"] = summarize(inputLatencies);
+
+    QJsonObject frameTime = report["frameTimeMs"].toObject();
+    QJsonObject inputToPaint = report["inputToPaintMs"].toObject();
+    qInfo("Frame time: p50 %.1f ms, p99 %.1f ms, max %.1f ms (%d frames)",
+          frameTime["p50"].toDouble(), frameTime["p99"].toDouble(), frameTime["max"].toDouble(),
+          frameTime["count"].toInt());
+    qInfo("Input to paint: p50 %.1f ms, p99 %.1f ms, max %.1f ms (%d paints)",
+          inputToPaint["p50"].toDouble(), inputToPaint["p99"].toDouble(), inputToPaint["max"].toDouble(),
+          inputToPaint["count"].toInt());
+
+    QFile file(reportPath);
+    if (!file.open(QFile::WriteOnly) || file.write(QJsonDocument(report).toJson()) < 0) {
+        qWarning("Replay report could not be saved to %s", qUtf8Printable(reportPath));
+        return false;
+    }
+
+    qInfo("Replay report saved to %s", qUtf8Printable(reportPath));
+    return true;
+}
+
+QJsonObject InputReplayer::summarize(const LatencyHistogram & histogram) {
+    QJsonObject summary;
+    summary["count"] = double(histogram.getCount());
+    summary["mean"] = histogram.getMean() / 1000.0;
+    summary["p50"] = histogram.getPercentile(50) / 1000.0;
+    summary["p90"] = histogram.getPercentile(90) / 1000.0;
+    summary["p99"] = histogram.getPercentile(99) / 1000.0;
+    summary["max"] = histogram.getMax() / 1000.0;
+
+    return summary;
+}
@@ -0,0 +1,78 @@
+#ifndef INPUTREPLAYER_H
+#define INPUTREPLAYER_H
+
+// Parent class
+#include <QObject>
+
+// Implementation classes
+#include <QAbstractButton>
+#include <QAbstractSlider>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QString>
+#include <QTimer>
+#include <QWheelEvent>
+#include <QWidget>
+
+#include "latencyhistogram.h"
+#include "pipelinemetrics.h"
+
+/*
+ * Replays a session recorded by InputRecorder with the same timing, and measures how the view keeps up:
+ * the time between paints, and the delay from each input to the first paint after it. Both are reported
+ * as distributions once the session ends, so rendering changes can be compared on the same session
+ */
+class InputReplayer : public QObject {
+    Q_OBJECT
+
+private:
+    QString reportPath;
+    QWidget * viewport;
+    QHash<QString, QAbstractSlider *> sliders;
+    QHash<QString, QAbstractButton *> buttons;
+
+    QJsonArray events;
+    int nextEvent = 0;
+    QElapsedTimer clock;
+    QTimer eventTimer;
+    bool isReplaying = false;
+
+    LatencyHistogram frameTimes;
+    LatencyHistogram inputLatencies;
+    qint64 lastPaintTime = 0;
+    // Oldest input that wasn't painted yet (0 if none)
+    qint64 unpaintedInputTime = 0;
+
+    void replayEvent(const QJsonObject & event);
+    bool writeReport();
+    static QJsonObject summarize(const LatencyHistogram & histogram);
+
+private slots:
+    void replayDueEvents();
+    void finish();
+
+public slots:
+    void start();
+    void framePainted();
+
+signals:
+    void finished(bool isReportWritten);
+
+public:
+    // Time to keep measuring paints after the last event
+    static const int SETTLE_MS = 500;
+
+    InputReplayer(const QString & reportPath, QWidget * viewport, QObject * parent = nullptr);
+
+    bool load(const QString & path);
+    void addSlider(const QString & name, QAbstractSlider * slider);
+    void addButton(const QString & name, QAbstractButton * button);
+};
+
+#endif // INPUTREPLAYER_H
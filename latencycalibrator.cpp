@@ -0,0 +1,158 @@
+#include "latencycalibrator.h"
+
+LatencyCalibrator::LatencyCalibrator(PatchItem * patch, QObject * parent)
+    : QObject(parent) {
+    this->patch = patch;
+    patch->setVisible(false);
+
+    timer.setSingleShot(true);
+    connect(&timer, SIGNAL (timeout()), this, SLOT (advance()));
+}
+
+/*
+ * Cover the viewport with the dark patch and start measuring once the webcam adjusted to it
+ */
+void LatencyCalibrator::start() {
+    latencies.clear();
+    darkLevel = 0;
+    darkFrames = 0;
+
+    patch->setColor(Qt::black);
+    patch->setVisible(true);
+
+    state = SETTLING;
+    timer.start(SETTLE_MS);
+}
+
+void LatencyCalibrator::cancel() {
+    if (isActive()) {
+        finish(false);
+    }
+}
+
+bool LatencyCalibrator::isActive() const {
+    return state != IDLE;
+}
+
+/*
+ * Called by the view with each webcam frame it receives
+ */
+void LatencyCalibrator::frameReceived(const QImage & img) {
+    double brightness = getBrightness(img);
+
+    switch (state) {
+        case MEASURING_DARK :
+            darkLevel += brightness / DARK_FRAMES;
+            darkFrames++;
+            if (darkFrames == DARK_FRAMES) {
+                flash();
+            }
+            break;
+        case WAITING_DETECTION :
+            if (brightness > darkLevel + MIN_CONTRAST) {
+                state = WAITING_DETECTED_PAINT;
+            }
+            break;
+        case RECOVERING :
+            if (brightness < darkLevel + MIN_CONTRAST / 2.0) {
+                state = WAITING_NEXT_FLASH;
+                timer.start(QRandomGenerator::global()->bounded(MIN_FLASH_INTERVAL_MS, MAX_FLASH_INTERVAL_MS));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Called by the view after each time it paints, which is when the screen changes
+ */
+void LatencyCalibrator::framePainted() {
+    switch (state) {
+        case WAITING_FLASH_PAINT :
+            flashTime = PipelineMetrics::now();
+            state = WAITING_DETECTION;
+            timer.start(TIMEOUT_MS);
+            break;
+        case WAITING_DETECTED_PAINT : {
+            qint64 latency = PipelineMetrics::now() - flashTime;
+            PipelineMetrics::instance()->record(PipelineMetrics::GLASS_TO_GLASS, latency);
+            latencies.push_back(latency / 1e6);
+
+            if (int(latencies.size()) == ROUNDS) {
+                finish(true);
+                break;
+            }
+
+            patch->setColor(Qt::black);
+            state = RECOVERING;
+            timer.start(TIMEOUT_MS);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/*
+ * Move on after waiting, or give up if the webcam didn't see the flash (or it fading)
+ */
+void LatencyCalibrator::advance() {
+    switch (state) {
+        case SETTLING :
+            state = MEASURING_DARK;
+            break;
+        case WAITING_NEXT_FLASH :
+            flash();
+            break;
+        case WAITING_DETECTION :
+        case RECOVERING :
+            finish(false);
+            break;
+        default:
+            break;
+    }
+}
+
+void LatencyCalibrator::flash() {
+    patch->setColor(Qt::white);
+    state = WAITING_FLASH_PAINT;
+    timer.stop();
+}
+
+void LatencyCalibrator::finish(bool isMeasured) {
+    timer.stop();
+    patch->setVisible(false);
+    state = IDLE;
+
+    double median = 0;
+    if (isMeasured && !latencies.empty()) {
+        std::nth_element(latencies.begin(), latencies.begin() + latencies.size() / 2, latencies.end());
+        median = latencies[latencies.size() / 2];
+    }
+
+    emit finished(isMeasured, median);
+}
+
+/*
+ * Average brightness (0-255) of a coarse grid of pixels, which is plenty to see the whole screen flash
+ */
+double LatencyCalibrator::getBrightness(const QImage & img) {
+    const int GRID_SIZE = 16;
+    if (img.isNull()) {
+        return 0;
+    }
+
+    bool isGrey = (img.format() == QImage::Format_Grayscale8);
+    double total = 0;
+    for (int row = 0; row < GRID_SIZE; row++) {
+        int y = (2 * row + 1) * img.height() / (2 * GRID_SIZE);
+        for (int col = 0; col < GRID_SIZE; col++) {
+            int x = (2 * col + 1) * img.width() / (2 * GRID_SIZE);
+            // Bytes of grey frames are read directly (quicker than looking up each pixel)
+            total += isGrey ? img.constScanLine(y)[x] : qGray(img.pixel(x, y));
+        }
+    }
+
+    return total / (GRID_SIZE * GRID_SIZE);
+}
@@ -0,0 +1,80 @@
+#ifndef LATENCYCALIBRATOR_H
+#define LATENCYCALIBRATOR_H
+
+// Parent class
+#include <QObject>
+
+// Implementation classes
+#include <algorithm>
+#include <vector>
+
+#include <QImage>
+#include <QRandomGenerator>
+#include <QTimer>
+
+#include "patchitem.h"
+#include "pipelinemetrics.h"
+
+/*
+ * Measures the delay between the screen changing and the change being shown on the screen through the
+ * webcam (glass to glass). The webcam must be pointed at the screen: the viewport is covered by a dark patch
+ * that flashes bright, and the delay is measured from the flash being painted until the first frame
+ * that sees it is painted. Repeated ROUNDS times, at random intervals so that flashes don't line up with frames
+ */
+class LatencyCalibrator : public QObject {
+    Q_OBJECT
+
+private:
+    enum State : int {
+        IDLE = 0,
+        // Waiting for exposure to adjust to the dark patch
+        SETTLING = 1,
+        MEASURING_DARK = 2,
+        WAITING_FLASH_PAINT = 3,
+        WAITING_DETECTION = 4,
+        WAITING_DETECTED_PAINT = 5,
+        // Waiting for frames to be dark again after a flash
+        RECOVERING = 6,
+        WAITING_NEXT_FLASH = 7,
+    };
+
+    PatchItem * patch;
+    State state = IDLE;
+    QTimer timer;
+
+    double darkLevel = 0;
+    int darkFrames = 0;
+    qint64 flashTime = 0;
+    std::vector<double> latencies;
+
+    void flash();
+    void finish(bool isMeasured);
+
+private slots:
+    void advance();
+
+public:
+    static const int ROUNDS = 10;
+    static const int DARK_FRAMES = 10;
+    // Brightness (out of 255) that the flash must add to a frame to be detected
+    static const int MIN_CONTRAST = 30;
+    static const int SETTLE_MS = 1000;
+    static const int TIMEOUT_MS = 2000;
+    static const int MIN_FLASH_INTERVAL_MS = 300;
+    static const int MAX_FLASH_INTERVAL_MS = 600;
+
+    LatencyCalibrator(PatchItem * patch, QObject * parent = nullptr);
+
+    void start();
+    void cancel();
+    bool isActive() const;
+    void frameReceived(const QImage & img);
+    void framePainted();
+    static double getBrightness(const QImage & img);
+
+signals:
+    // Median delay in milliseconds, if every flash was seen
+    void finished(bool isMeasured, double medianMs);
+};
+
+#endif // LATENCYCALIBRATOR_H
@@ -0,0 +1,101 @@
+#include "latencyhistogram.h"
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+/*
+ * Count one duration. Only relaxed atomic increments, so recording never waits for readers or other writers
+ */
+void LatencyHistogram::record(quint64 us) {
+    buckets[getBucket(us)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(us, std::memory_order_relaxed);
+
+    quint64 curMax = maximum.load(std::memory_order_relaxed);
+    while (us > curMax && !maximum.compare_exchange_weak(curMax, us, std::memory_order_relaxed)) {
+    }
+}
+
+/*
+ * Forget every duration (durations recorded at the same time may be partly kept)
+ */
+void LatencyHistogram::reset() {
+    for (std::atomic<quint64> & bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::getCount() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::getMean() const {
+    quint64 curCount = getCount();
+    return (curCount > 0) ? total.load(std::memory_order_relaxed) / curCount : 0;
+}
+
+quint64 LatencyHistogram::getMax() const {
+    return maximum.load(std::memory_order_relaxed);
+}
+
+/*
+ * Smallest duration that the given percentage (0-100) of durations don't exceed, to the precision of its bucket
+ */
+quint64 LatencyHistogram::getPercentile(double percentile) const {
+    // Count from the buckets themselves, which may be ahead of the total count while recording
+    quint64 counts[BUCKET_COUNT];
+    quint64 curCount = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        curCount += counts[i];
+    }
+    if (curCount == 0) {
+        return 0;
+    }
+
+    percentile = qBound(0.0, percentile, 100.0);
+    quint64 rank = qMax(quint64(1), quint64(percentile / 100 * curCount + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // Highest value of the bucket, and never more than the highest value recorded
+            return qMin(getBucketValue(i + 1) - 1, qMax(getBucketValue(i), getMax()));
+        }
+    }
+
+    return getMax();
+}
+
+/*
+ * Values below SUB_BUCKETS have a bucket each. Above that, the top SUB_BUCKET_BITS + 1 bits of the value
+ * pick one of SUB_BUCKETS buckets in its power of two
+ */
+int LatencyHistogram::getBucket(quint64 value) {
+    value = qMin(value, (quint64(1) << MAX_VALUE_BITS));
+    if (value < quint64(SUB_BUCKETS)) {
+        return int(value);
+    }
+
+    int highestBit = 63 - qCountLeadingZeroBits(value);
+    int shift = highestBit - SUB_BUCKET_BITS;
+    int subBucket = int(value >> shift) - SUB_BUCKETS;
+    return SUB_BUCKETS + shift * SUB_BUCKETS + subBucket;
+}
+
+/*
+ * Lowest value that falls in the bucket
+ */
+quint64 LatencyHistogram::getBucketValue(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return quint64(bucket);
+    }
+
+    int shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    int subBucket = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return quint64(SUB_BUCKETS + subBucket) << shift;
+}
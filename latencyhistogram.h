@@ -0,0 +1,46 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+// Implementation classes
+#include <atomic>
+
+#include <QtAlgorithms>
+#include <QtGlobal>
+
+/*
+ * Histogram of durations in microseconds that can be recorded from any thread without locking.
+ * Buckets are log-linear (like HDR histograms): every power of two is split into SUB_BUCKETS equal
+ * buckets, so percentiles are accurate to about 6% from a microsecond up to over an hour
+ */
+class LatencyHistogram {
+
+private:
+    std::atomic<quint64> count;
+    std::atomic<quint64> total;
+    std::atomic<quint64> maximum;
+
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // Durations are clamped to 2^32 microseconds
+    static const int MAX_VALUE_BITS = 32;
+    static const int BUCKET_COUNT = SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+private:
+    std::atomic<quint64> buckets[BUCKET_COUNT];
+
+    static int getBucket(quint64 value);
+    static quint64 getBucketValue(int bucket);
+
+public:
+    LatencyHistogram();
+
+    void record(quint64 us);
+    void reset();
+    quint64 getCount() const;
+    quint64 getMean() const;
+    quint64 getMax() const;
+    quint64 getPercentile(double percentile) const;
+};
+
+#endif // LATENCYHISTOGRAM_H
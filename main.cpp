@@ -1,12 +1,84 @@
 #include "mainwindow.h"
+#include "camerasource.h"
+#include "imagesequencesource.h"
+#include "syntheticsource.h"
+#include "videofilesource.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRegularExpression>
 #include <QFile>
 #include <QString>
+#include <QThread>
+#include <QTimer>
+
+/*
+ * Frame source chosen on the command line instead of the saved webcam (empty if none).
+ * Exits with usage if a source is given incorrectly
+ */
+static cv::Ptr<FrameSource> parseFrameSource(QCommandLineParser & parser, const QApplication & app) {
+    QCommandLineOption cameraOption("camera", "Play webcam <index>.", "index");
+    QCommandLineOption videoOption("video", "Play video <file> in a loop, at its own frame rate.", "file");
+    QCommandLineOption imagesOption("images", "Play the images in <dir> in a loop, in file name order.", "dir");
+    QCommandLineOption syntheticOption("synthetic", "Play a generated page of text at <size>, e.g. 1920x1080.", "size");
+    QCommandLineOption fpsOption("fps", "Frame rate of --images and --synthetic (default 30).", "rate", "30");
+    parser.addOptions({cameraOption, videoOption, imagesOption, syntheticOption, fpsOption});
+    parser.addHelpOption();
+    parser.process(app);
+
+    bool isFpsValid = false;
+    double fps = parser.value(fpsOption).toDouble(&isFpsValid);
+    if (!isFpsValid || fps <= 0) {
+        qCritical("Invalid frame rate: %s", qPrintable(parser.value(fpsOption)));
+        parser.showHelp(1);
+    }
+
+    if (parser.isSet(cameraOption)) {
+        bool isIndexValid = false;
+        int device = parser.value(cameraOption).toInt(&isIndexValid);
+        if (!isIndexValid || device < 0) {
+            qCritical("Invalid webcam index: %s", qPrintable(parser.value(cameraOption)));
+            parser.showHelp(1);
+        }
+        return cv::makePtr<CameraSource>(device);
+    }
+    if (parser.isSet(videoOption)) {
+        return cv::makePtr<VideoFileSource>(parser.value(videoOption));
+    }
+    if (parser.isSet(imagesOption)) {
+        return cv::makePtr<ImageSequenceSource>(parser.value(imagesOption), fps);
+    }
+    if (parser.isSet(syntheticOption)) {
+        QRegularExpressionMatch match = QRegularExpression("^(\\d+)x(\\d+)$").match(parser.value(syntheticOption));
+        if (!match.hasMatch()) {
+            qCritical("Invalid size: %s", qPrintable(parser.value(syntheticOption)));
+            parser.showHelp(1);
+        }
+        cv::Size size(match.captured(1).toInt(), match.captured(2).toInt());
+        return cv::makePtr<SyntheticSource>(size, fps);
+    }
+
+    return cv::Ptr<FrameSource>();
+}
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QApplication a(argc, argv);
+    // Name shown for this thread in traces
+    QThread::currentThread()->setObjectName("GUI");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Magnifies reading material under a webcam.");
+    QCommandLineOption recordOption("record-input", "Record input to <file> until the window closes.", "file");
+    QCommandLineOption replayOption("replay-input", "Replay input recorded in <file>, then quit.", "file");
+    QCommandLineOption reportOption("replay-report", "Write the replay's frame & input timings to <file> "
+                                    "(default replay-report.json).", "file", "replay-report.json");
+    parser.addOptions({recordOption, replayOption, reportOption});
+    cv::Ptr<FrameSource> source = parseFrameSource(parser, a);
 
     // Use large font (18 point size, system default if larger)
     QFont defaultFont = a.font();
@@ -23,8 +95,37 @@ int main(int argc, char *argv[])
         a.setStyleSheet(stylesheet);
     }
     file.close();
-    MainWindow w;
+    // Source given on the command line replaces the saved webcam, which is then never opened
+    if (!source.empty()) {
+        qInfo("Playing %s", qPrintable(source->getName()));
+    }
+    MainWindow w(source);
+    // Snapshot from the last session is only shown with the webcam, so recorded input always starts the same way
+    if (source.empty() && !parser.isSet(recordOption) && !parser.isSet(replayOption)) {
+        w.restoreSession();
+    }
+
+    if (parser.isSet(recordOption)) {
+        w.recordInput(parser.value(recordOption));
+    }
+    if (parser.isSet(replayOption)) {
+        if (!w.replayInput(parser.value(replayOption), parser.value(reportOption))) {
+            qCritical("Cannot read input session: %s", qPrintable(parser.value(replayOption)));
+            return 1;
+        }
+        QObject::connect(&w, &MainWindow::inputReplayFinished, [&a](bool isReportWritten) {
+            a.exit(isReportWritten ? 0 : 1);
+        });
+    }
+
+    // Report startup time separately for the window (shown once the event loop starts) and the first webcam frame
+    QObject::connect(&w, &MainWindow::firstFrameShown, [&startupTimer]() {
+        qInfo("Time to first frame: %lld ms", startupTimer.elapsed());
+    });
     w.show();
+    QTimer::singleShot(0, [&startupTimer]() {
+        qInfo("Time to first window: %lld ms", startupTimer.elapsed());
+    });
 
     return a.exec();
 }
@@ -1,11 +1,14 @@
 #include "mainwindow.h"
 
-MainWindow::MainWindow(QWidget *parent)
+/*
+ * Main window playing the chosen webcam, or the given frame source instead (then the webcam is never opened)
+ */
+MainWindow::MainWindow(cv::Ptr<FrameSource> source, QWidget *parent)
     : QMainWindow(parent)
 {
     // Set window layout
     window = new QWidget(this);
-    QGridLayout * wLayout = createMainLayout();
+    QGridLayout * wLayout = createMainLayout(source);
 
     window->setLayout(wLayout);
     this->setCentralWidget(window);
@@ -32,6 +35,11 @@ void MainWindow::updateWebcamMode() {
             modeButton->setIcon(QIcon(":/media/icons/videocam.png"));
             modeButton->setEnabled(true);
             break;
+        case WebcamView::PANORAMA :
+            modeButton->setToolTip(PANORAMA_TOOLTIP);
+            modeButton->setIcon(QIcon(":/media/icons/image.png"));
+            modeButton->setEnabled(true);
+            break;
         case WebcamView::ERROR :
         default :
             modeButton->setToolTip(ERROR_TOOLTIP);
@@ -39,6 +47,11 @@ void MainWindow::updateWebcamMode() {
             modeButton->setEnabled(false);
             break;
     }
+
+    // Scanning a page can only start from the live video
+    if (panoramaButton != nullptr) {
+        panoramaButton->setEnabled(view->getMode() == WebcamView::PREVIEW);
+    }
 }
 
 /*
@@ -51,6 +64,7 @@ void MainWindow::switchWebcamMode() {
             view->setMode(WebcamView::PREVIEW);
             break;
         case WebcamView::PREVIEW :
+        case WebcamView::PANORAMA :
             view->setMode(WebcamView::SNAPSHOT);
             break;
         case WebcamView::ERROR :
@@ -60,11 +74,20 @@ void MainWindow::switchWebcamMode() {
     }
 }
 
+/*
+ * Start stitching the page together from the live video. The mode button finishes the scan
+ */
+void MainWindow::startPanorama() {
+    if (view->getMode() == WebcamView::PREVIEW) {
+        view->setMode(WebcamView::PANORAMA);
+    }
+}
+
 /*
  * Layout for displaying interactive widgets that change the display
  */
 QHBoxLayout * MainWindow::createButtonLayout() {
-     QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
+    SettingsModel * model = SettingsModel::instance();
 
     QHBoxLayout * buttonLayout = new QHBoxLayout(this);
 
@@ -72,10 +95,14 @@ QHBoxLayout * MainWindow::createButtonLayout() {
     zoomSlider = new QSlider(Qt::Horizontal, this);
     modeButton = new QPushButton(this);
     settingsButton = new QPushButton(this);
+    panoramaButton = new QPushButton("Scan", this);
+    documentButton = new QPushButton("Document", this);
 
     // Set tooltips and icons for buttons
     fullscreenButton->setToolTip(WINDOW_TOOLTIP);
     settingsButton->setToolTip("Settings");
+    panoramaButton->setToolTip(SCAN_TOOLTIP);
+    documentButton->setToolTip(DOCUMENT_TOOLTIP);
 
     // Give the mode button the appropriate icon && tooltip
     updateWebcamMode();
@@ -86,13 +113,9 @@ QHBoxLayout * MainWindow::createButtonLayout() {
     // Artificially widens size alloted for widget for stylesheet
     zoomSlider->setTickPosition(QSlider::TicksBothSides);
 
-    double minZoomFactor = (settings.contains("image/minZoom"))
-            ? settings.value("image/minZoom").toDouble()
-            : 1.0;
+    double minZoomFactor = model->getMinZoom();
     zoomSlider->setMinimum( int(-100 * (1-minZoomFactor)) );
-    int maxZoomPos = (settings.contains("image/maxZoom"))
-                   ? settings.value("image/maxZoom").toInt() * 100
-                   : 5 * 100;
+    int maxZoomPos = model->getMaxZoom() * 100;
     zoomSlider->setMaximum(maxZoomPos);
     zoomSlider->setTickInterval( int((zoomSlider->maximum() - zoomSlider->minimum())/10) );
     zoomSlider->setSingleStep(1);
@@ -119,6 +142,8 @@ QHBoxLayout * MainWindow::createButtonLayout() {
     buttonLayout->addWidget(zoomSlider);
     buttonLayout->addWidget(maxZoomLabel);
     buttonLayout->addWidget(modeButton);
+    buttonLayout->addWidget(panoramaButton);
+    buttonLayout->addWidget(documentButton);
     buttonLayout->addWidget(settingsButton);
 
     // Customize layout
@@ -127,20 +152,31 @@ QHBoxLayout * MainWindow::createButtonLayout() {
     fullscreenButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     modeButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     settingsButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    panoramaButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    documentButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 
     // Additional customization in stylesheet with these object names
     fullscreenButton->setObjectName("main");
     modeButton->setObjectName("main");
     settingsButton->setObjectName("main");
+    panoramaButton->setObjectName("main");
+    documentButton->setObjectName("main");
     zoomTitle->setObjectName("title");
 
     // "Settings" button opens dialog box for modifying advanced settings
     connect(settingsButton, SIGNAL (released()), this, SLOT (openSettingsDialog()));
     // Change Mode from still image to video feed & vice versa
     connect(modeButton, SIGNAL (released()), this, SLOT (switchWebcamMode()));
+    // Scan a page larger than the camera can see
+    connect(panoramaButton, SIGNAL (released()), this, SLOT (startPanorama()));
+    // Keep snapshots as the pages of a document
+    connect(documentButton, SIGNAL (released()), this, SLOT (toggleDocument()));
     connect(view, SIGNAL (modeChanged()), this, SLOT (updateWebcamMode()), Qt::QueuedConnection);
     connect(zoomSlider, SIGNAL  (valueChanged(int)), this, SLOT (zoomImage(int)));
     connect(fullscreenButton, SIGNAL (released()), this, SLOT (toggleFullscreen()));
+    // Follow zoom limits as they are changed in settings
+    connect(model, SIGNAL (minZoomChanged(double)), this, SLOT (applyZoomLimits()));
+    connect(model, SIGNAL (maxZoomChanged(int)), this, SLOT (applyZoomLimits()));
 
     return buttonLayout;
 }
@@ -148,34 +184,44 @@ QHBoxLayout * MainWindow::createButtonLayout() {
 /*
  * Layout for displaying graphics and button for advanced image modifications
  */
-QVBoxLayout * MainWindow::createGraphicsLayout() {
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
+QVBoxLayout * MainWindow::createGraphicsLayout(cv::Ptr<FrameSource> source) {
+    SettingsModel * model = SettingsModel::instance();
 
     QVBoxLayout * graphicsLayout = new QVBoxLayout(this);
 
-    view = new WebcamView(this);
+    // Frames come from the source until another webcam is chosen
+    isSourceOverridden = !source.empty();
+    view = new WebcamView(this, source);
+    connect(view, SIGNAL (firstFrameShown()), this, SIGNAL (firstFrameShown()));
 
     graphicsLayout->addWidget(view);
 
+    // Thumbnails of earlier snapshots under the image, to show them again
+    gallery = new SnapshotGallery(view->getHistory(), this);
+    graphicsLayout->addWidget(gallery);
+    connect(gallery, SIGNAL (snapshotSelected(int)), view, SLOT (showSnapshot(int)));
+    applyHistorySettings();
+
     // Take up as much screen as possible
     view->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
 
-    // Update view settings
-    if (settings.contains("image/brightness")) {
-        view->setBrightness(settings.value("image/brightness").toDouble());
-    }
-
-    if (settings.contains("image/contrast")) {
-        view->setContrast(settings.value("image/contrast").toDouble());
-    }
-
-    if (settings.contains("image/colorFilter")) {
-        view->setFilter(settings.value("image/colorFilter").toString().toStdString());
-    }
-
-    if (settings.contains("image/angle")) {
-        view->setRotation( settings.value("image/angle").toInt() );
-    }
+    // Update view settings, and again whenever they change (including while previewed in the settings dialog)
+    applyImageSettings();
+    curWebcam = model->getDeviceIndex();
+    curWebcamName = model->getDeviceName();
+
+    connect(model, SIGNAL (brightnessChanged(double)), this, SLOT (applyImageSettings()));
+    connect(model, SIGNAL (contrastChanged(double)), this, SLOT (applyImageSettings()));
+    connect(model, SIGNAL (colorFilterChanged(QString)), this, SLOT (applyImageSettings()));
+    connect(model, SIGNAL (angleChanged(int)), this, SLOT (applyImageSettings()));
+    connect(model, SIGNAL (lineDrawnChanged(bool)), this, SLOT (applyGuidingLineSettings()));
+    connect(model, SIGNAL (linePosChanged(int)), this, SLOT (applyGuidingLineSettings()));
+    connect(model, SIGNAL (lineThicknessChanged(int)), this, SLOT (applyGuidingLineSettings()));
+    connect(model, SIGNAL (lineColorChanged(QColor)), this, SLOT (applyGuidingLineSettings()));
+    connect(model, SIGNAL (clickToDragChanged(bool)), this, SLOT (applyControlSettings()));
+    connect(model, SIGNAL (maxFpsChanged(int)), this, SLOT (applyVideoSettings()));
+    connect(model, SIGNAL (historyMemoryChanged(int)), this, SLOT (applyHistorySettings()));
+    connect(DeviceRegistry::instance(), SIGNAL (devicesChanged()), this, SLOT (followWebcam()));
 
     return graphicsLayout;
 }
@@ -183,10 +229,10 @@ QVBoxLayout * MainWindow::createGraphicsLayout() {
 /*
  * Entire Layout for MainWindow
  */
-QGridLayout * MainWindow::createMainLayout() {
+QGridLayout * MainWindow::createMainLayout(cv::Ptr<FrameSource> source) {
     QGridLayout * mainLayout = new QGridLayout(this);
 
-    QVBoxLayout * graphicsLayout = createGraphicsLayout();
+    QVBoxLayout * graphicsLayout = createGraphicsLayout(source);
     QHBoxLayout * buttonLayout = createButtonLayout();
 
     // Graphics layout spans across most of the window
@@ -201,154 +247,183 @@ QGridLayout * MainWindow::createMainLayout() {
  * Bring up dialog box for changing advanced settings
  */
 void MainWindow::openSettingsDialog() {
-    settingsDialog = new SettingsDialog(this);
+    {
+        TRACE_SCOPE("Open settings dialog");
+        settingsDialog = new SettingsDialog(this);
+    }
 
-    connect( settingsDialog, SIGNAL (tempSettingsChanged()), this, SLOT (trySettings()) );
-    connect( settingsDialog, SIGNAL (accepted()), this, SLOT (saveSettings()) );
+    connect( settingsDialog, SIGNAL (accepted()), this, SLOT (changeWebcam()) );
 
     // Prevent main window from being intseracted with until dialog closed (i.e. make it modal)
+    isSettingsOpen = true;
     settingsDialog->exec();
+    isSettingsOpen = false;
+
+    // Catch up with webcams plugged in or out while the dialog was open
+    followWebcam();
 }
 
 /*
- * Change settings based on values selected from settings window
+ * Record input over the image & the main controls until the window closes, to replay it later
  */
-void MainWindow::saveSettings() {
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
-
-    // Update webcam
-    if (settings.contains("webcam/deviceIndex") && settings.contains("webcam/deviceName")) {
-        int newWebcam = settings.value("webcam/deviceIndex").toInt();
-        QString newWebcamName = settings.value("webcam/deviceName").toString();
-        if (curWebcamName != newWebcamName || curWebcam != newWebcam) {
-            curWebcam = newWebcam;
-            curWebcamName = newWebcamName;
-
-            view->openWebcam(newWebcam);
-        }
-    }
-
-    // Updat zoom labels and limits
-    if (settings.contains("image/minZoom")) {
-        double minZoomFactor = settings.value("image/minZoom").toDouble();
-        QString minZoomText;
-        minZoomText += QString::number(minZoomFactor);
-        minZoomText += "x";
-        minZoomLabel->setText(minZoomText);
-
-        zoomSlider->blockSignals(true);
-        zoomSlider->setMinimum( int(-100 * (1-minZoomFactor)) );
-        zoomSlider->blockSignals(false);
-    }
-
-    if (settings.contains("image/maxZoom")) {
-        int maxZoomFactor = settings.value("image/maxZoom").toInt();
-        QString maxZoomText;
-        maxZoomText += QString::number(maxZoomFactor);
-        maxZoomText += "x";
-        maxZoomLabel->setText(maxZoomText);
-
-        zoomSlider->blockSignals(true);
-        zoomSlider->setMaximum(100 * maxZoomFactor);
-        zoomSlider->blockSignals(false);
-    }
-
-    // Update view settings
-    if (settings.contains("image/brightness")) {
-        view->setBrightness(settings.value("image/brightness").toDouble());
-    }
-
-    if (settings.contains("image/contrast")) {
-        view->setContrast(settings.value("image/contrast").toDouble());
-    }
-
-    if (settings.contains("image/colorFilter")) {
-        view->setFilter(settings.value("image/colorFilter").toString().toStdString());
-    }
+void MainWindow::recordInput(const QString & path) {
+    InputRecorder * recorder = new InputRecorder(path, view->viewport(), this);
+    recorder->watchSlider("zoom", zoomSlider);
+    recorder->watchButton("mode", modeButton);
+    recorder->watchButton("scan", panoramaButton);
+    recorder->watchButton("fullscreen", fullscreenButton);
+}
 
-    if (settings.contains("controls/clickToDrag")) {
-        view->setClickToDragEnabled( settings.value("controls/clickToDrag").toBool() );
-    }
+/*
+ * Replay recorded input once the first frame is shown, then write a report of how quickly it was painted
+ * (inputReplayFinished() is emitted once done). Returns false if the session can't be read
+ */
+bool MainWindow::replayInput(const QString & sessionPath, const QString & reportPath) {
+    InputReplayer * replayer = new InputReplayer(reportPath, view->viewport(), this);
+    if (!replayer->load(sessionPath)) {
+        delete replayer;
+        return false;
+    }
+
+    replayer->addSlider("zoom", zoomSlider);
+    replayer->addButton("mode", modeButton);
+    replayer->addButton("scan", panoramaButton);
+    replayer->addButton("fullscreen", fullscreenButton);
+    connect(view, SIGNAL (painted()), replayer, SLOT (framePainted()));
+    connect(view, SIGNAL (firstFrameShown()), replayer, SLOT (start()));
+    connect(replayer, SIGNAL (finished(bool)), this, SIGNAL (inputReplayFinished(bool)));
+
+    return true;
+}
 
-    if (settings.contains("image/angle")) {
-        view->setRotation( settings.value("image/angle").toInt() );
+/*
+ * Show the snapshot that was on screen when the app last closed, and keep the one on screen when it closes again.
+ * Returns false if there was none
+ */
+bool MainWindow::restoreSession() {
+    isSessionKept = true;
+    if (!view->restoreSession(getSessionPath())) {
+        return false;
     }
 
-    if (settings.contains("controls/isLineDrawn")) {
-        view->setGuidingLineEnabled( settings.value("controls/isLineDrawn").toBool() );
-    }
+    zoomSlider->setValue( qRound((view->getZoom() - 1) * 100) );
+    return true;
+}
 
-    if (settings.contains("controls/linePos")) {
-        // Change percentage to fraction of position down the screen
-        view->setGuidingLinePos( settings.value("controls/linePos").toDouble() / 100 );
-    }
+QString MainWindow::getSessionPath() {
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+    dir.mkpath(".");
+    return dir.filePath(SESSION_FILE_NAME);
+}
 
-    if (settings.contains("controls/lineThickness")) {
-        view->setGuidingLineThickness( settings.value("controls/lineThickness").toInt() );
-    }
+/*
+ * Switch to the webcam selected in the settings window
+ */
+void MainWindow::changeWebcam() {
+    SettingsModel * model = SettingsModel::instance();
 
-    if (settings.contains("controls/lineColor")) {
-        QColor color = QColor( settings.value("controls/lineColor").toString() );
-        if (color.isValid()) {
-            view->setGuidingLineColor(color);
-        }
-    }
+    int newWebcam = model->getDeviceIndex();
+    QString newWebcamName = model->getDeviceName();
+    bool isError = (view->getMode() == WebcamView::ERROR);
+    if (curWebcamName != newWebcamName || curWebcam != newWebcam || isError) {
+        curWebcam = newWebcam;
+        curWebcamName = newWebcamName;
+        isSourceOverridden = false;
 
-    if (view->getMode() == WebcamView::SNAPSHOT) {
+        view->openWebcam(newWebcam);
     }
 
     // If previous webcam resulted in an error, try again
-    if (view->getMode() == WebcamView::ERROR) {
+    if (isError) {
         view->setMode(WebcamView::PREVIEW);
     }
 }
 
 /*
- * Dynamically change image settings while the values are being changed
+ * Keep the chosen webcam open when webcams are plugged in or out (which can change its index)
  */
-void MainWindow::trySettings() {
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
-
-    if (settings.contains("image/tempBrightness")) {
-        view->setBrightness( settings.value("image/tempBrightness").toDouble() );
+void MainWindow::followWebcam() {
+    SettingsModel * model = SettingsModel::instance();
+    // Devices chosen in the settings dialog aren't changed while it's being edited
+    if (isSourceOverridden || isSettingsOpen) {
+        return;
     }
 
-    if (settings.contains("image/tempContrast")) {
-        view->setContrast( settings.value("image/tempContrast").toDouble() );
+    // Webcam is unknown or unplugged (so keep using the last index), or its index didn't change
+    int index = DeviceRegistry::instance()->findIndex( model->getDeviceId() );
+    if (index < 0 || index == curWebcam) {
+        return;
     }
 
-    if (settings.contains("image/tempColorFilter")) {
-        view->setFilter( settings.value("image/tempColorFilter").toString().toStdString() );
-    }
+    // Mode is left alone (a snapshot stays on screen, and a webcam error is retried from the settings)
+    model->setDeviceIndex(index);
+    curWebcam = index;
+    curWebcamName = model->getDeviceName();
+    view->openWebcam(index);
+}
 
-    if (settings.contains("image/tempAngle")) {
-        view->setRotation( settings.value("image/tempAngle").toInt() );
-    }
+/*
+ * Update zoom labels and limits
+ */
+void MainWindow::applyZoomLimits() {
+    SettingsModel * model = SettingsModel::instance();
 
-    if (settings.contains("controls/tempIsLineDrawn")) {
-        view->setGuidingLineEnabled( settings.value("controls/tempIsLineDrawn").toBool() );
-    }
+    double minZoomFactor = model->getMinZoom();
+    QString minZoomText;
+    minZoomText += QString::number(minZoomFactor);
+    minZoomText += "x";
+    minZoomLabel->setText(minZoomText);
 
-    if (settings.contains("controls/tempLinePos")) {
-        // Change percentage to fraction of position down the screen
-        view->setGuidingLinePos( settings.value("controls/tempLinePos").toDouble() / 100 );
-    }
+    int maxZoomFactor = model->getMaxZoom();
+    QString maxZoomText;
+    maxZoomText += QString::number(maxZoomFactor);
+    maxZoomText += "x";
+    maxZoomLabel->setText(maxZoomText);
 
-    if (settings.contains("controls/tempLineThickness")) {
-        view->setGuidingLineThickness( settings.value("controls/tempLineThickness").toInt() );
-    }
+    zoomSlider->blockSignals(true);
+    zoomSlider->setMinimum( int(-100 * (1-minZoomFactor)) );
+    zoomSlider->setMaximum(100 * maxZoomFactor);
+    zoomSlider->blockSignals(false);
+}
 
-    if (settings.contains("controls/tempLineColor")) {
-        QColor color = QColor( settings.value("controls/tempLineColor").toString() );
-        if (color.isValid()) {
-            view->setGuidingLineColor(color);
-        }
-    }
+/*
+ * Change image settings as soon as their values change
+ */
+void MainWindow::applyImageSettings() {
+    TRACE_SCOPE("Apply image settings");
+    SettingsModel * model = SettingsModel::instance();
+
+    view->setBrightness( model->getBrightness() );
+    view->setContrast( model->getContrast() );
+    view->setFilter( model->getColorFilter().toStdString() );
+    view->setRotation( model->getAngle() );
 
     if (view->getMode() == WebcamView::SNAPSHOT) {
         view->processSnapshotImage();
     }
+}
+
+void MainWindow::applyGuidingLineSettings() {
+    SettingsModel * model = SettingsModel::instance();
 
+    view->setGuidingLineEnabled( model->isLineDrawn() );
+    // Change percentage to fraction of position down the screen
+    view->setGuidingLinePos( double(model->getLinePos()) / 100 );
+    view->setGuidingLineThickness( model->getLineThickness() );
+    view->setGuidingLineColor( model->getLineColor() );
+}
+
+void MainWindow::applyControlSettings() {
+    view->setClickToDragEnabled( SettingsModel::instance()->isClickToDrag() );
+}
+
+void MainWindow::applyVideoSettings() {
+    view->setMaxFps( SettingsModel::instance()->getMaxFps() );
+}
+
+void MainWindow::applyHistorySettings() {
+    // Setting is in MB
+    view->getHistory()->setMemoryBudget( qint64(SettingsModel::instance()->getHistoryMemory()) * 1024 * 1024 );
 }
 
 /*
@@ -361,7 +436,8 @@ void MainWindow::resizeEvent(QResizeEvent * event) {
 }
 
 /*
- * Leave Fullscreen mode if Esc key pressed
+ * Leave Fullscreen mode if Esc key pressed, toggle statistics if F3 pressed, measure latency if F4 pressed,
+ * toggle tracing if F5 pressed
  */
 void MainWindow::keyPressEvent(QKeyEvent * event) {
     QMainWindow::keyPressEvent(event);
@@ -369,6 +445,81 @@ void MainWindow::keyPressEvent(QKeyEvent * event) {
     if (this->isFullScreen() && event->key() == Qt::Key_Escape) {
         toggleFullscreen();
     }
+    // Frame rate & timing statistics
+    else if (event->key() == Qt::Key_F3) {
+        view->setStatsVisible(!view->isStatsVisible());
+    }
+    // Measure delay from screen to webcam to screen
+    else if (event->key() == Qt::Key_F4) {
+        view->startLatencyCalibration();
+    }
+    // Start tracing, or stop and save the trace
+    else if (event->key() == Qt::Key_F5) {
+        toggleTracing();
+    }
+}
+
+/*
+ * Start recording trace events, or stop and write them to a file in the documents folder
+ * (open it with chrome://tracing or https://ui.perfetto.dev)
+ */
+void MainWindow::toggleTracing() {
+    if (!Tracer::isEnabled()) {
+        Tracer::clear();
+        Tracer::setEnabled(true);
+        qInfo("Tracing started");
+        return;
+    }
+
+    Tracer::setEnabled(false);
+    QString fileName = QString("MagniRead-trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+    QString path = QDir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)).filePath(fileName);
+    if (Tracer::dump(path)) {
+        qInfo("Trace saved to %s", qUtf8Printable(path));
+    }
+    else {
+        qWarning("Trace could not be saved to %s", qUtf8Printable(path));
+    }
+}
+
+/*
+ * Start adding every new snapshot to a PDF document, or finish the document and save it in the documents folder
+ * (it's written in the background)
+ */
+void MainWindow::toggleDocument() {
+    if (document == nullptr) {
+        QString fileName = QString("MagniRead-document-%1.pdf").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+        QString path = QDir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)).filePath(fileName);
+        document = new DocumentWriter(path, this);
+        connect(document, SIGNAL (documentWritten(bool, QString, int)),
+                this, SLOT (reportDocument(bool, QString, int)), Qt::QueuedConnection);
+        connect(document, SIGNAL (documentWritten(bool, QString, int)),
+                document, SLOT (deleteLater()), Qt::QueuedConnection);
+        view->setDocument(document);
+
+        documentButton->setText("Save");
+        documentButton->setToolTip(SAVE_DOCUMENT_TOOLTIP);
+    }
+    else {
+        view->setDocument(nullptr);
+        document->finish();
+        document = nullptr;
+
+        documentButton->setText("Document");
+        documentButton->setToolTip(DOCUMENT_TOOLTIP);
+    }
+}
+
+void MainWindow::reportDocument(bool isWritten, const QString & path, int pageCount) {
+    if (isWritten) {
+        qInfo("Document of %d page(s) saved to %s", pageCount, qUtf8Printable(path));
+    }
+    else if (pageCount == 0) {
+        qInfo("Document has no pages, so it wasn't saved");
+    }
+    else {
+        qWarning("Document could not be saved to %s", qUtf8Printable(path));
+    }
 }
 
 /*
@@ -394,11 +545,12 @@ void MainWindow::toggleFullscreen() {
  */
 void MainWindow::zoomImage(int zoomValue) {
     double zoomRatio = 1 + double(zoomValue)/100;
-    QMatrix matrix;
-    matrix.scale(zoomRatio, zoomRatio);
-    view->setMatrix(matrix);
+    view->setZoom(zoomRatio);
 }
 
 MainWindow::~MainWindow()
 {
+    if (isSessionKept) {
+        view->saveSession(getSessionPath());
+    }
 }
@@ -5,7 +5,9 @@
 #include <QMainWindow>
 
 // Implementation classes
+#include <QDateTime>
 #include <QDialog>
+#include <QDir>
 #include <QBoxLayout>
 #include <QGridLayout>
 #include <QFormLayout>
@@ -14,9 +16,15 @@
 #include <QPushButton>
 #include <QSlider>
 #include <QResizeEvent>
+#include <QStandardPaths>
 
+#include "documentwriter.h"
 #include "webcamview.h"
+#include "snapshotgallery.h"
 #include "settingsdialog.h"
+#include "inputrecorder.h"
+#include "inputreplayer.h"
+#include "tracer.h"
 
 class MainWindow : public QMainWindow
 {
@@ -25,43 +33,79 @@ class MainWindow : public QMainWindow
 private:
     QWidget * window = nullptr;
     WebcamView * view = nullptr;
+    SnapshotGallery * gallery = nullptr;
     QPushButton * modeButton;
     QPushButton * fullscreenButton;
     QPushButton * settingsButton;
+    QPushButton * panoramaButton = nullptr;
+    QPushButton * documentButton = nullptr;
     QSlider * zoomSlider = nullptr;
     QLabel * minZoomLabel;
     QLabel * maxZoomLabel;
     int curWebcam = 0;
     QString curWebcamName = "";
+    // Whether frames come from a source given on the command line instead of the chosen webcam
+    bool isSourceOverridden = false;
+    // Whether the settings dialog is open (the chosen webcam isn't followed meanwhile)
+    bool isSettingsOpen = false;
+    // Whether the snapshot on screen is saved when the window closes, to be shown on the next start
+    bool isSessionKept = false;
+    // Document that snapshots are being added to (null unless one is being made)
+    DocumentWriter * document = nullptr;
 
     SettingsDialog * settingsDialog;
 
     const char * SNAPSHOT_TOOLTIP = "Preview camera";
     const char * PREVIEW_TOOLTIP = "Take a snapshot";
     const char * ERROR_TOOLTIP = "Cannot find camera";
+    const char * PANORAMA_TOOLTIP = "Finish scanning page";
+    const char * SCAN_TOOLTIP = "Scan a large page by slowly moving it under the camera";
+    const char * DOCUMENT_TOOLTIP = "Keep every snapshot as a page of a PDF document";
+    const char * SAVE_DOCUMENT_TOOLTIP = "Finish the document and save it to the documents folder";
     const char * FULLSCREEN_TOOLTIP = "Return to Window";
     const char * WINDOW_TOOLTIP = "Enter Fullscreen";
+    const char * SESSION_FILE_NAME = "session.snapshot";
 
-    QGridLayout * createMainLayout();
-    QVBoxLayout * createGraphicsLayout();
+    QGridLayout * createMainLayout(cv::Ptr<FrameSource> source);
+    QVBoxLayout * createGraphicsLayout(cv::Ptr<FrameSource> source);
     QHBoxLayout * createButtonLayout();
+    void toggleTracing();
+    QString getSessionPath();
 
 private slots:
     void openSettingsDialog();
     void updateWebcamMode();
-    void saveSettings();
+    void applyImageSettings();
+    void applyGuidingLineSettings();
+    void applyControlSettings();
+    void applyVideoSettings();
+    void applyHistorySettings();
+    void applyZoomLimits();
+    void changeWebcam();
+    void followWebcam();
+    void startPanorama();
     void switchWebcamMode();
+    void toggleDocument();
+    void reportDocument(bool isWritten, const QString & path, int pageCount);
     void toggleFullscreen();
-    void trySettings();
     void zoomImage(int value);
 
+signals:
+    // Forwarded from the view, to measure startup time
+    void firstFrameShown();
+    void inputReplayFinished(bool isReportWritten);
+
 protected:
     void resizeEvent(QResizeEvent * event);
     void keyPressEvent(QKeyEvent * event);
 
 public:
-    MainWindow(QWidget * parent = nullptr);
+    MainWindow(cv::Ptr<FrameSource> source = cv::Ptr<FrameSource>(), QWidget * parent = nullptr);
     ~MainWindow();
+
+    void recordInput(const QString & path);
+    bool replayInput(const QString & sessionPath, const QString & reportPath);
+    bool restoreSession();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,41 @@
+#include "messageitem.h"
+
+MessageItem::MessageItem(QGraphicsItem * parent)
+    : OverlayItem(parent) {
+}
+
+QString MessageItem::getText() const {
+    return text;
+}
+
+void MessageItem::setText(const QString & text) {
+    this->text = text;
+    update();
+}
+
+/*
+ * Cover the whole viewport, so the text stays centred
+ */
+void MessageItem::setViewportSize(QSize size) {
+    if (size != viewportSize) {
+        prepareGeometryChange();
+    }
+    OverlayItem::setViewportSize(size);
+}
+
+QRectF MessageItem::boundingRect() const {
+    return QRectF(QPointF(0, 0), viewportSize);
+}
+
+void MessageItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget) {
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    // Twice the application's (already large) font size
+    QFont font = QApplication::font();
+    font.setPointSize(font.pointSize() * 2);
+
+    painter->setFont(font);
+    painter->setPen(Qt::darkGray);
+    painter->drawText(boundingRect(), Qt::AlignCenter | Qt::TextWordWrap, text);
+}
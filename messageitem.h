@@ -0,0 +1,32 @@
+#ifndef MESSAGEITEM_H
+#define MESSAGEITEM_H
+
+// Parent class
+#include "overlayitem.h"
+
+// Implementation classes
+#include <QApplication>
+#include <QFont>
+#include <QPainter>
+#include <QString>
+#include <QStyleOptionGraphicsItem>
+
+/*
+ * Short message centred in the viewport, shown in place of the video when there is nothing to show yet
+ */
+class MessageItem : public OverlayItem {
+
+private:
+    QString text;
+
+public:
+    MessageItem(QGraphicsItem * parent = nullptr);
+
+    QString getText() const;
+    void setText(const QString & text);
+    void setViewportSize(QSize size);
+    QRectF boundingRect() const;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr);
+};
+
+#endif // MESSAGEITEM_H
@@ -0,0 +1,260 @@
+#include "mosaiccanvas.h"
+
+/*
+ * Index of the tile containing a coordinate (rounds towards negative infinity)
+ */
+static int tileIndex(int coord, int tileSize) {
+    return (coord >= 0) ? coord / tileSize : -((-coord + tileSize - 1) / tileSize);
+}
+
+MosaicCanvas::MosaicCanvas(int tileSize, int maxTilesInMemory) {
+    this->tileSize = (tileSize > 0) ? tileSize : 512;
+    this->maxTilesInMemory = (maxTilesInMemory > 0) ? maxTilesInMemory : 1;
+}
+
+/*
+ * Remove every tile from memory and disk
+ */
+void MosaicCanvas::clear() {
+    for (const TileKey & key : storedTiles) {
+        QFile::remove(tilePath(key));
+    }
+    storedTiles.clear();
+    tiles.clear();
+    lru.clear();
+
+    bounds = cv::Rect();
+    overview.release();
+    overviewOrigin = cv::Point();
+    overviewScale = 0.25;
+    type = -1;
+}
+
+bool MosaicCanvas::isEmpty() const {
+    return bounds.area() == 0;
+}
+
+cv::Rect MosaicCanvas::getBounds() const {
+    return bounds;
+}
+
+/*
+ * Copy an image onto the canvas with its top-left corner at the given canvas coordinate
+ */
+void MosaicCanvas::write(const cv::Mat & img, cv::Point origin) {
+    if (img.empty()) {
+        return;
+    }
+
+    if (type == -1) {
+        type = img.type();
+    }
+    else if (img.type() != type) {
+        return;
+    }
+
+    cv::Rect area(origin, img.size());
+    for (int ty = tileIndex(area.y, tileSize); ty <= tileIndex(area.br().y - 1, tileSize); ty++) {
+        for (int tx = tileIndex(area.x, tileSize); tx <= tileIndex(area.br().x - 1, tileSize); tx++) {
+            cv::Rect tileRect(tx * tileSize, ty * tileSize, tileSize, tileSize);
+            cv::Rect overlap = area & tileRect;
+
+            Tile & tile = getTile(TileKey(tx, ty));
+            cv::Mat dst = tile.pixels(overlap - tileRect.tl());
+            img(overlap - origin).copyTo(dst);
+            tile.dirty = true;
+        }
+    }
+
+    bounds = isEmpty() ? area : (bounds | area);
+    updateOverview(img, origin);
+    evictTiles();
+}
+
+/*
+ * Copy a region of the canvas at full resolution. Parts that were never written are black
+ */
+cv::Mat MosaicCanvas::read(cv::Rect region) {
+    if (isEmpty() || region.area() == 0) {
+        return cv::Mat();
+    }
+
+    cv::Mat result(region.size(), type, cv::Scalar::all(0));
+    for (int ty = tileIndex(region.y, tileSize); ty <= tileIndex(region.br().y - 1, tileSize); ty++) {
+        for (int tx = tileIndex(region.x, tileSize); tx <= tileIndex(region.br().x - 1, tileSize); tx++) {
+            TileKey key(tx, ty);
+            if (tiles.count(key) == 0 && storedTiles.count(key) == 0) {
+                continue;
+            }
+
+            cv::Rect tileRect(tx * tileSize, ty * tileSize, tileSize, tileSize);
+            cv::Rect overlap = region & tileRect;
+
+            Tile & tile = getTile(key);
+            cv::Mat dst = result(overlap - region.tl());
+            tile.pixels(overlap - tileRect.tl()).copyTo(dst);
+        }
+    }
+
+    evictTiles();
+    return result;
+}
+
+/*
+ * Compose the whole canvas at the given scale, one tile at a time
+ */
+cv::Mat MosaicCanvas::render(double scale) {
+    if (isEmpty() || scale <= 0) {
+        return cv::Mat();
+    }
+
+    cv::Size size(std::max(1, cvRound(bounds.width * scale)), std::max(1, cvRound(bounds.height * scale)));
+    cv::Mat result(size, type, cv::Scalar::all(0));
+
+    std::set<TileKey> keys(storedTiles);
+    for (const auto & entry : tiles) {
+        keys.insert(entry.first);
+    }
+
+    for (const TileKey & key : keys) {
+        cv::Rect tileRect(key.first * tileSize, key.second * tileSize, tileSize, tileSize);
+        cv::Rect overlap = bounds & tileRect;
+        if (overlap.area() == 0) {
+            continue;
+        }
+
+        // Destination of this tile in the scaled result
+        cv::Point from((overlap.tl() - bounds.tl()) * scale);
+        cv::Point to((overlap.br() - bounds.tl()) * scale);
+        cv::Rect dstRect = cv::Rect(from, to) & cv::Rect(cv::Point(), size);
+        if (dstRect.area() == 0) {
+            continue;
+        }
+
+        Tile & tile = getTile(key);
+        cv::Mat dst = result(dstRect);
+        cv::resize(tile.pixels(overlap - tileRect.tl()), dst, dstRect.size(), 0, 0, cv::INTER_AREA);
+        evictTiles();
+    }
+
+    return result;
+}
+
+/*
+ * Downscaled copy of the canvas that is kept up to date while writing (never larger than MAX_OVERVIEW_SIZE)
+ */
+cv::Mat MosaicCanvas::getOverview() const {
+    return overview;
+}
+
+/*
+ * Get tile from memory, loading it from disk or creating a blank one if necessary
+ */
+MosaicCanvas::Tile & MosaicCanvas::getTile(const TileKey & key) {
+    auto found = tiles.find(key);
+    if (found != tiles.end()) {
+        // Mark as most recently used
+        lru.splice(lru.begin(), lru, found->second.lruPos);
+        return found->second;
+    }
+
+    Tile & tile = tiles[key];
+    if (storedTiles.count(key) == 0 || !loadTile(key, tile)) {
+        tile.pixels = cv::Mat(tileSize, tileSize, type, cv::Scalar::all(0));
+        tile.dirty = false;
+    }
+    lru.push_front(key);
+    tile.lruPos = lru.begin();
+
+    return tile;
+}
+
+/*
+ * Write least recently used tiles to disk until the memory limit is respected
+ */
+void MosaicCanvas::evictTiles() {
+    while (int(tiles.size()) > maxTilesInMemory) {
+        TileKey key = lru.back();
+        Tile & tile = tiles[key];
+
+        // Tiles that can't be stored are kept in memory rather than lost
+        if (tile.dirty || storedTiles.count(key) == 0) {
+            if (!storeTile(key, tile)) {
+                break;
+            }
+            storedTiles.insert(key);
+        }
+
+        lru.pop_back();
+        tiles.erase(key);
+    }
+}
+
+QString MosaicCanvas::tilePath(const TileKey & key) const {
+    return tileDir.filePath(QString("%1_%2.tile").arg(key.first).arg(key.second));
+}
+
+/*
+ * Save raw tile pixels (uncompressed, so that they are quick to read back)
+ */
+bool MosaicCanvas::storeTile(const TileKey & key, const Tile & tile) {
+    if (!tileDir.isValid()) {
+        return false;
+    }
+
+    QFile file(tilePath(key));
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+
+    qint64 length = qint64(tile.pixels.total() * tile.pixels.elemSize());
+    return file.write(reinterpret_cast<const char *>(tile.pixels.data), length) == length;
+}
+
+bool MosaicCanvas::loadTile(const TileKey & key, Tile & tile) {
+    QFile file(tilePath(key));
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    tile.pixels = cv::Mat(tileSize, tileSize, type);
+    tile.dirty = false;
+    qint64 length = qint64(tile.pixels.total() * tile.pixels.elemSize());
+    return file.read(reinterpret_cast<char *>(tile.pixels.data), length) == length;
+}
+
+/*
+ * Draw newly written image onto the overview, growing (and shrinking the scale of) the overview as needed
+ */
+void MosaicCanvas::updateOverview(const cv::Mat & img, cv::Point origin) {
+    // Halve the scale until the whole canvas fits
+    while (bounds.width * overviewScale > MAX_OVERVIEW_SIZE || bounds.height * overviewScale > MAX_OVERVIEW_SIZE) {
+        overviewScale /= 2;
+        if (!overview.empty()) {
+            cv::resize(overview, overview, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+        }
+    }
+
+    // Grow overview to cover the canvas bounds
+    cv::Size size(std::max(1, cvCeil(bounds.width * overviewScale)), std::max(1, cvCeil(bounds.height * overviewScale)));
+    if (overview.empty() || overview.size() != size || overviewOrigin != bounds.tl()) {
+        cv::Mat grown(size, type, cv::Scalar::all(0));
+        if (!overview.empty()) {
+            cv::Point offset((overviewOrigin - bounds.tl()) * overviewScale);
+            cv::Rect dstRect = cv::Rect(offset, overview.size()) & cv::Rect(cv::Point(), size);
+            cv::Mat dst = grown(dstRect);
+            overview(dstRect - offset).copyTo(dst);
+        }
+        overview = grown;
+        overviewOrigin = bounds.tl();
+    }
+
+    cv::Mat scaled;
+    cv::resize(img, scaled, cv::Size(), overviewScale, overviewScale, cv::INTER_AREA);
+    cv::Point offset((origin - overviewOrigin) * overviewScale);
+    cv::Rect dstRect = cv::Rect(offset, scaled.size()) & cv::Rect(cv::Point(), overview.size());
+    if (dstRect.area() > 0) {
+        cv::Mat dst = overview(dstRect);
+        scaled(dstRect - offset).copyTo(dst);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef MOSAICCANVAS_H
+#define MOSAICCANVAS_H
+
+// Implementation classes
+#include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+#include <utility>
+
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+/*
+ * Unbounded image canvas split into fixed-size tiles. Only a limited number of tiles stay in
+ * memory; the least recently used ones are written to a temporary directory and read back when needed
+ */
+class MosaicCanvas {
+
+private:
+    typedef std::pair<int, int> TileKey;
+
+    struct Tile {
+        cv::Mat pixels;
+        bool dirty = false;
+        std::list<TileKey>::iterator lruPos;
+    };
+
+    int tileSize;
+    int maxTilesInMemory;
+    int type = -1;
+
+    // Area of the canvas that has been written to
+    cv::Rect bounds;
+
+    // Tiles in memory, ordered from most to least recently used
+    std::map<TileKey, Tile> tiles;
+    std::list<TileKey> lru;
+    // Tiles that only exist on disk
+    std::set<TileKey> storedTiles;
+    QTemporaryDir tileDir;
+
+    // Downscaled copy of the whole canvas, for display while it grows
+    cv::Mat overview;
+    cv::Point overviewOrigin;
+    double overviewScale = 0.25;
+
+    Tile & getTile(const TileKey & key);
+    void evictTiles();
+    QString tilePath(const TileKey & key) const;
+    bool storeTile(const TileKey & key, const Tile & tile);
+    bool loadTile(const TileKey & key, Tile & tile);
+    void updateOverview(const cv::Mat & img, cv::Point origin);
+
+public:
+    static const int MAX_OVERVIEW_SIZE = 2048;
+
+    MosaicCanvas(int tileSize = 512, int maxTilesInMemory = 64);
+
+    void clear();
+    bool isEmpty() const;
+    cv::Rect getBounds() const;
+    void write(const cv::Mat & img, cv::Point origin);
+    cv::Mat read(cv::Rect region);
+    cv::Mat render(double scale);
+    cv::Mat getOverview() const;
+};
+
+#endif // MOSAICCANVAS_H
@@ -0,0 +1,26 @@
+#include "overlayitem.h"
+
+OverlayItem::OverlayItem(QGraphicsItem * parent)
+    : QGraphicsItem(parent) {
+    setFlag(QGraphicsItem::ItemIgnoresTransformations);
+    setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    setZValue(OVERLAY_Z_VALUE);
+}
+
+/*
+ * Position of the item's origin in viewport coordinates
+ */
+QPointF OverlayItem::getViewportPos() const {
+    return viewportPos;
+}
+
+void OverlayItem::setViewportPos(QPointF pos) {
+    viewportPos = pos;
+}
+
+/*
+ * Called by the view when the viewport is resized, so the item can lay itself out again
+ */
+void OverlayItem::setViewportSize(QSize size) {
+    viewportSize = size;
+}
@@ -0,0 +1,35 @@
+#ifndef OVERLAYITEM_H
+#define OVERLAYITEM_H
+
+// Parent class
+#include <QGraphicsItem>
+
+// Implementation classes
+#include <QPointF>
+#include <QSize>
+
+/*
+ * Item drawn over the image at a fixed position of the viewport, unaffected by zooming and dragging.
+ * Its drawing is cached, so moving it with the view only costs a copy of the cached pixmap
+ */
+class OverlayItem : public QGraphicsItem {
+
+private:
+    QPointF viewportPos;
+
+protected:
+    QSize viewportSize;
+
+    void setViewportPos(QPointF pos);
+
+public:
+    // Drawn above every image item
+    static const int OVERLAY_Z_VALUE = 10;
+
+    OverlayItem(QGraphicsItem * parent = nullptr);
+
+    QPointF getViewportPos() const;
+    virtual void setViewportSize(QSize size);
+};
+
+#endif // OVERLAYITEM_H
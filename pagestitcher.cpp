@@ -0,0 +1,213 @@
+#include "pagestitcher.h"
+
+PageStitcher::PageStitcher()
+    : matcher(cv::NORM_HAMMING, true) {
+    detector = cv::ORB::create(1000);
+}
+
+/*
+ * Discard the current mosaic to start stitching a new page
+ */
+void PageStitcher::reset() {
+    canvas.clear();
+    lastPosition = cv::Point2d();
+    lastSize = cv::Size();
+    lastKeypoints.clear();
+    lastDescriptors.release();
+    lastScale = 1;
+}
+
+bool PageStitcher::isEmpty() const {
+    return canvas.isEmpty();
+}
+
+/*
+ * Register frame against the mosaic and add it if the page moved far enough. Returns whether the mosaic changed
+ */
+bool PageStitcher::addFrame(const cv::Mat & frame) {
+    if (frame.empty()) {
+        return false;
+    }
+
+    double scale = getMatchScale(frame);
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    detectFeatures(frame, scale, keypoints, descriptors);
+
+    // First frame starts the mosaic
+    if (canvas.isEmpty()) {
+        canvas.write(frame, cv::Point(0, 0));
+        lastPosition = cv::Point2d(0, 0);
+        lastSize = frame.size();
+        lastKeypoints = keypoints;
+        lastDescriptors = descriptors;
+        lastScale = scale;
+        return true;
+    }
+
+    if (frame.size() != lastSize) {
+        return false;
+    }
+
+    cv::Point2d shift;
+    if (!estimateCoarseShift(keypoints, descriptors, scale, shift)) {
+        return false;
+    }
+
+    // Wait until there is enough new page to be worth writing
+    if (std::abs(shift.x) < MIN_MOVEMENT * frame.cols && std::abs(shift.y) < MIN_MOVEMENT * frame.rows) {
+        return false;
+    }
+
+    cv::Point2d position = lastPosition + shift;
+    if (!refinePosition(frame, position)) {
+        return false;
+    }
+
+    canvas.write(frame, cv::Point(cvRound(position.x), cvRound(position.y)));
+    lastPosition = position;
+    lastKeypoints = keypoints;
+    lastDescriptors = descriptors;
+    lastScale = scale;
+
+    return true;
+}
+
+/*
+ * Downscaled view of the whole mosaic (bounded in size however large the page gets)
+ */
+cv::Mat PageStitcher::getOverview() const {
+    return canvas.getOverview();
+}
+
+/*
+ * Full mosaic, downscaled only if it's larger than MAX_RENDER_PIXELS
+ */
+cv::Mat PageStitcher::render() {
+    cv::Rect bounds = canvas.getBounds();
+    if (bounds.area() == 0) {
+        return cv::Mat();
+    }
+
+    double scale = std::min(1.0, std::sqrt(double(MAX_RENDER_PIXELS) / bounds.area()));
+    return canvas.render(scale);
+}
+
+/*
+ * Scale factor to downsample frames to MATCH_WIDTH before matching features
+ */
+double PageStitcher::getMatchScale(const cv::Mat & frame) {
+    return (frame.cols > MATCH_WIDTH) ? double(MATCH_WIDTH) / frame.cols : 1.0;
+}
+
+void PageStitcher::detectFeatures(const cv::Mat & frame, double scale,
+                                  std::vector<cv::KeyPoint> & keypoints, cv::Mat & descriptors) {
+    cv::Mat small;
+    if (scale < 1) {
+        cv::resize(frame, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+    else {
+        small = frame;
+    }
+
+    cv::Mat grey;
+    if (small.channels() == 3) {
+        cv::cvtColor(small, grey, CV_BGR2GRAY);
+    }
+    else {
+        grey = small;
+    }
+
+    detector->detectAndCompute(grey, cv::noArray(), keypoints, descriptors);
+}
+
+/*
+ * Estimate how far the page moved since the last frame in the mosaic (in full resolution pixels).
+ * Only translation is used, since the page slides flat under a fixed camera; estimates with noticeable
+ * rotation or scaling are rejected as mismatches
+ */
+bool PageStitcher::estimateCoarseShift(const std::vector<cv::KeyPoint> & keypoints, const cv::Mat & descriptors,
+                                       double scale, cv::Point2d & shift) {
+    if (descriptors.empty() || lastDescriptors.empty()) {
+        return false;
+    }
+
+    std::vector<cv::DMatch> matches;
+    matcher.match(descriptors, lastDescriptors, matches);
+    if (int(matches.size()) < MIN_INLIERS) {
+        return false;
+    }
+
+    std::vector<cv::Point2f> framePoints;
+    std::vector<cv::Point2f> lastPoints;
+    for (const cv::DMatch & match : matches) {
+        framePoints.push_back(keypoints[size_t(match.queryIdx)].pt * float(1 / scale));
+        lastPoints.push_back(lastKeypoints[size_t(match.trainIdx)].pt * float(1 / lastScale));
+    }
+
+    // Maps frame coordinates to last frame coordinates
+    std::vector<uchar> inliers;
+    cv::Mat transform = cv::estimateAffinePartial2D(framePoints, lastPoints, inliers, cv::RANSAC, 3 / scale);
+    if (transform.empty() || cv::countNonZero(inliers) < MIN_INLIERS) {
+        return false;
+    }
+
+    double a = transform.at<double>(0, 0);
+    double b = transform.at<double>(1, 0);
+    double zoom = std::sqrt(a * a + b * b);
+    double degrees = std::atan2(b, a) * 180 / CV_PI;
+    if (std::abs(zoom - 1) > 0.05 || std::abs(degrees) > 3) {
+        return false;
+    }
+
+    shift = cv::Point2d(transform.at<double>(0, 2), transform.at<double>(1, 2));
+    return true;
+}
+
+/*
+ * Correct the estimated position by phase correlation against the mosaic, where the frame overlaps
+ * the last frame written (so the mosaic is known to be filled in)
+ */
+bool PageStitcher::refinePosition(const cv::Mat & frame, cv::Point2d & position) {
+    cv::Rect predicted(cvRound(position.x), cvRound(position.y), frame.cols, frame.rows);
+    cv::Rect last(cvRound(lastPosition.x), cvRound(lastPosition.y), lastSize.width, lastSize.height);
+    cv::Rect overlap = predicted & last;
+    if (overlap.width < 64 || overlap.height < 64) {
+        return false;
+    }
+
+    // Correlating the centre of the overlap is enough, and much cheaper at 4K+
+    int width = std::min(overlap.width, 1024);
+    int height = std::min(overlap.height, 1024);
+    cv::Rect region(overlap.x + (overlap.width - width) / 2, overlap.y + (overlap.height - height) / 2, width, height);
+
+    cv::Mat mosaicPart = canvas.read(region);
+    cv::Mat framePart = frame(region - predicted.tl());
+
+    cv::Mat mosaicGrey, frameGrey;
+    if (frame.channels() == 3) {
+        cv::cvtColor(mosaicPart, mosaicGrey, CV_BGR2GRAY);
+        cv::cvtColor(framePart, frameGrey, CV_BGR2GRAY);
+    }
+    else {
+        mosaicGrey = mosaicPart;
+        frameGrey = framePart;
+    }
+    mosaicGrey.convertTo(mosaicGrey, CV_32F);
+    frameGrey.convertTo(frameGrey, CV_32F);
+
+    cv::Mat window;
+    cv::createHanningWindow(window, region.size(), CV_32F);
+
+    double response = 0;
+    cv::Point2d residual = cv::phaseCorrelate(mosaicGrey, frameGrey, window, &response);
+
+    // Weak or large corrections mean the coarse estimate can't be trusted
+    if (response < 0.05 || std::abs(residual.x) > width / 8.0 || std::abs(residual.y) > height / 8.0) {
+        return false;
+    }
+
+    // Frame part appears shifted by the residual relative to the mosaic, so move the frame back by it
+    position = cv::Point2d(predicted.tl()) - residual;
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef PAGESTITCHER_H
+#define PAGESTITCHER_H
+
+// Implementation classes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "mosaiccanvas.h"
+
+/*
+ * Builds a mosaic of a page that is slowly moved under the camera. Each frame is registered against
+ * the mosaic: coarsely by matching features on downsampled frames, then refined by phase correlation
+ * at full resolution against the mosaic itself (so that errors don't accumulate from frame to frame)
+ */
+class PageStitcher {
+
+private:
+    MosaicCanvas canvas;
+    cv::Ptr<cv::ORB> detector;
+    cv::BFMatcher matcher;
+
+    // Last frame written to the mosaic, and where it was written
+    cv::Point2d lastPosition;
+    cv::Size lastSize;
+    std::vector<cv::KeyPoint> lastKeypoints;
+    cv::Mat lastDescriptors;
+    double lastScale = 1;
+
+    double getMatchScale(const cv::Mat & frame);
+    void detectFeatures(const cv::Mat & frame, double scale,
+                        std::vector<cv::KeyPoint> & keypoints, cv::Mat & descriptors);
+    bool estimateCoarseShift(const std::vector<cv::KeyPoint> & keypoints, const cv::Mat & descriptors,
+                             double scale, cv::Point2d & shift);
+    bool refinePosition(const cv::Mat & frame, cv::Point2d & position);
+
+public:
+    // Width that frames are downsampled to before matching features
+    static const int MATCH_WIDTH = 640;
+    // Minimum number of consistent feature matches to accept a frame
+    static const int MIN_INLIERS = 15;
+    // Fraction of the frame that the page must move before the mosaic is updated
+    static constexpr double MIN_MOVEMENT = 0.1;
+    // Largest stitched page that is rendered at once (about 8K UHD)
+    static const int MAX_RENDER_PIXELS = 7680 * 4320;
+
+    PageStitcher();
+
+    void reset();
+    bool isEmpty() const;
+    bool addFrame(const cv::Mat & frame);
+    cv::Mat getOverview() const;
+    cv::Mat render();
+};
+
+#endif // PAGESTITCHER_H
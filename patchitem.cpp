@@ -0,0 +1,32 @@
+#include "patchitem.h"
+
+PatchItem::PatchItem(QGraphicsItem * parent)
+    : OverlayItem(parent) {
+}
+
+QColor PatchItem::getColor() const {
+    return color;
+}
+
+void PatchItem::setColor(QColor color) {
+    this->color = color;
+    update();
+}
+
+void PatchItem::setViewportSize(QSize size) {
+    if (size != viewportSize) {
+        prepareGeometryChange();
+    }
+    OverlayItem::setViewportSize(size);
+}
+
+QRectF PatchItem::boundingRect() const {
+    return QRectF(QPointF(0, 0), viewportSize);
+}
+
+void PatchItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget) {
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    painter->fillRect(boundingRect(), color);
+}
@@ -0,0 +1,30 @@
+#ifndef PATCHITEM_H
+#define PATCHITEM_H
+
+// Parent class
+#include "overlayitem.h"
+
+// Implementation classes
+#include <QColor>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+/*
+ * Plain colour covering the whole viewport
+ */
+class PatchItem : public OverlayItem {
+
+private:
+    QColor color = Qt::black;
+
+public:
+    PatchItem(QGraphicsItem * parent = nullptr);
+
+    QColor getColor() const;
+    void setColor(QColor color);
+    void setViewportSize(QSize size);
+    QRectF boundingRect() const;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr);
+};
+
+#endif // PATCHITEM_H
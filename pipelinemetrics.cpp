@@ -0,0 +1,139 @@
+#include "pipelinemetrics.h"
+
+PipelineMetrics::PipelineMetrics()
+    : currentWindow(0), framesShown(0), framesDropped(0), framesUnchanged(0), framesSkipped(0), qualityLevel(0) {
+    clock.start();
+}
+
+/*
+ * Metrics shared by the whole application
+ */
+PipelineMetrics * PipelineMetrics::instance() {
+    static PipelineMetrics metrics;
+    return &metrics;
+}
+
+/*
+ * Monotonic time in nanoseconds, comparable between threads
+ */
+qint64 PipelineMetrics::now() {
+    return instance()->clock.nsecsElapsed();
+}
+
+const char * PipelineMetrics::getStageName(Stage stage) {
+    switch (stage) {
+        case READ :
+            return "Read";
+        case SCALE :
+            return "Scale";
+        case ADJUST :
+            return "Adjust";
+        case ROTATE :
+            return "Rotate";
+        case FILTER :
+            return "Filter";
+        case CONVERT :
+            return "Convert";
+        case QUEUE_WAIT :
+            return "Queue wait";
+        case UPLOAD :
+            return "Upload";
+        case PAINT :
+            return "Paint";
+        case CAPTURE_TO_PRESENT :
+            return "Capture>paint";
+        case GLASS_TO_GLASS :
+            return "Glass>glass";
+        case STAGE_COUNT :
+        default:
+            return "";
+    }
+}
+
+/*
+ * Record how long a stage took, in nanoseconds (kept to the microsecond)
+ */
+void PipelineMetrics::record(Stage stage, qint64 ns) {
+    if (stage >= 0 && stage < STAGE_COUNT) {
+        int window = isWindowed(stage) ? currentWindow.load(std::memory_order_relaxed) : 0;
+        windows[window][stage].record(quint64(qMax(qint64(0), ns) / 1000));
+    }
+}
+
+void PipelineMetrics::countFrameShown() {
+    framesShown.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ * Count a frame that was replaced by a newer one before it could be painted
+ */
+void PipelineMetrics::countFrameDropped() {
+    framesDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ * Count a frame that wasn't processed because the page didn't move
+ */
+void PipelineMetrics::countFrameUnchanged() {
+    framesUnchanged.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ * Count a frame that wasn't processed because the display couldn't show it (see WebcamPlayer::setFrameInterval)
+ */
+void PipelineMetrics::countFrameSkipped() {
+    framesSkipped.fetch_add(1, std::memory_order_relaxed);
+}
+
+quint64 PipelineMetrics::getFramesShown() const {
+    return framesShown.load(std::memory_order_relaxed);
+}
+
+quint64 PipelineMetrics::getFramesDropped() const {
+    return framesDropped.load(std::memory_order_relaxed);
+}
+
+/*
+ * Quality level that video frames are processed at (see QualityGovernor)
+ */
+void PipelineMetrics::setQualityLevel(int level) {
+    qualityLevel.store(level, std::memory_order_relaxed);
+}
+
+int PipelineMetrics::getQualityLevel() const {
+    return qualityLevel.load(std::memory_order_relaxed);
+}
+
+quint64 PipelineMetrics::getFramesUnchanged() const {
+    return framesUnchanged.load(std::memory_order_relaxed);
+}
+
+quint64 PipelineMetrics::getFramesSkipped() const {
+    return framesSkipped.load(std::memory_order_relaxed);
+}
+
+/*
+ * Times of a stage during the last completed window (all glass to glass measurements)
+ */
+const LatencyHistogram & PipelineMetrics::getHistogram(Stage stage) const {
+    int window = isWindowed(stage) ? 1 - currentWindow.load(std::memory_order_relaxed) : 0;
+    return windows[window][stage];
+}
+
+/*
+ * Complete the window being recorded, so that getHistogram() returns it, and start recording a new one.
+ * Only called from the GUI thread
+ */
+void PipelineMetrics::startWindow() {
+    int next = 1 - currentWindow.load(std::memory_order_relaxed);
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        if (isWindowed(Stage(i))) {
+            windows[next][i].reset();
+        }
+    }
+    currentWindow.store(next, std::memory_order_relaxed);
+}
+
+bool PipelineMetrics::isWindowed(Stage stage) {
+    return stage != GLASS_TO_GLASS;
+}
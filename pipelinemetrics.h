@@ -0,0 +1,79 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+// Implementation classes
+#include <atomic>
+
+#include <QElapsedTimer>
+
+#include "latencyhistogram.h"
+
+/*
+ * How long each stage of showing a webcam frame takes, from reading it to painting it, and how many frames
+ * are shown or dropped. Stages are recorded from both the player and the GUI threads.
+ *
+ * Stage times are kept per window (see startWindow()), so that they follow the current load rather than
+ * the whole session. Glass to glass latency is only measured on request, so it is kept until measured again
+ */
+class PipelineMetrics {
+
+public:
+    enum Stage : int {
+        // Reading the frame from the webcam
+        READ = 0,
+        // Downscaling, when processing at lower quality
+        SCALE = 1,
+        // Contrast & brightness
+        ADJUST = 2,
+        ROTATE = 3,
+        FILTER = 4,
+        // Conversion to QImage
+        CONVERT = 5,
+        // Time the frame waits for the GUI thread
+        QUEUE_WAIT = 6,
+        // Copy of the frame into the pixmap that is drawn
+        UPLOAD = 7,
+        PAINT = 8,
+        // Whole delay from the frame being read to it being painted
+        CAPTURE_TO_PRESENT = 9,
+        // Delay from the screen changing to the change being painted, measured by LatencyCalibrator
+        GLASS_TO_GLASS = 10,
+        STAGE_COUNT = 11,
+    };
+
+private:
+    QElapsedTimer clock;
+    // Window being recorded, and the last one completed (glass to glass latency is always in the first)
+    LatencyHistogram windows[2][STAGE_COUNT];
+    std::atomic<int> currentWindow;
+    std::atomic<quint64> framesShown;
+    std::atomic<quint64> framesDropped;
+    std::atomic<quint64> framesUnchanged;
+    std::atomic<quint64> framesSkipped;
+    std::atomic<int> qualityLevel;
+
+    PipelineMetrics();
+
+    static bool isWindowed(Stage stage);
+
+public:
+    static PipelineMetrics * instance();
+    static qint64 now();
+    static const char * getStageName(Stage stage);
+
+    void record(Stage stage, qint64 ns);
+    void countFrameShown();
+    void countFrameDropped();
+    void countFrameUnchanged();
+    void countFrameSkipped();
+    quint64 getFramesShown() const;
+    quint64 getFramesDropped() const;
+    quint64 getFramesUnchanged() const;
+    quint64 getFramesSkipped() const;
+    void setQualityLevel(int level);
+    int getQualityLevel() const;
+    const LatencyHistogram & getHistogram(Stage stage) const;
+    void startWindow();
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,102 @@
+#include "pyramidbuilder.h"
+
+PyramidBuilder::PyramidBuilder(QObject * parent)
+    : QThread(parent) {
+}
+
+/*
+ * Start building a pyramid for the image, abandoning any pyramid that isn't finished yet
+ */
+void PyramidBuilder::build(const QImage & img) {
+    mutex.lock();
+    pendingImage = img;
+    hasPending = true;
+    cancelled = true;
+    requested.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+}
+
+/*
+ * Abandon the pyramid being built and any that were requested
+ */
+void PyramidBuilder::cancel() {
+    mutex.lock();
+    pendingImage = QImage();
+    hasPending = false;
+    cancelled = true;
+    mutex.unlock();
+}
+
+/*
+ * Get the last pyramid that was built (null if none was built since the last call)
+ */
+QSharedPointer<TilePyramid> PyramidBuilder::takePyramid() {
+    mutex.lock();
+    QSharedPointer<TilePyramid> builtPyramid = pyramid;
+    pyramid.clear();
+    mutex.unlock();
+
+    return builtPyramid;
+}
+
+bool PyramidBuilder::isCancelled() {
+    mutex.lock();
+    bool isCancelled = cancelled;
+    mutex.unlock();
+
+    return isCancelled;
+}
+
+/*
+ * Wait for requests and halve each image until it fits in a single tile
+ */
+void PyramidBuilder::run() {
+    forever {
+        mutex.lock();
+        while (!hasPending && !stopping) {
+            requested.wait(&mutex);
+        }
+        if (stopping) {
+            mutex.unlock();
+            break;
+        }
+        QImage img = pendingImage;
+        pendingImage = QImage();
+        hasPending = false;
+        cancelled = false;
+        mutex.unlock();
+
+        QSharedPointer<TilePyramid> newPyramid(new TilePyramid(img.cacheKey()));
+        QImage level = TilePyramid::normalizeFormat(img);
+        while (!level.isNull() && !isCancelled()) {
+            newPyramid->addLevel(level);
+            if (level.width() <= TilePyramid::TILE_SIZE && level.height() <= TilePyramid::TILE_SIZE) {
+                break;
+            }
+            level = TilePyramid::downsample(level);
+        }
+
+        if (!isCancelled() && !newPyramid->isEmpty()) {
+            mutex.lock();
+            pyramid = newPyramid;
+            mutex.unlock();
+
+            emit pyramidBuilt();
+        }
+    }
+}
+
+PyramidBuilder::~PyramidBuilder() {
+    mutex.lock();
+    stopping = true;
+    cancelled = true;
+    requested.wakeAll();
+    mutex.unlock();
+
+    // Stop running thread
+    wait();
+}
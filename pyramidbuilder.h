@@ -0,0 +1,48 @@
+#ifndef PYRAMIDBUILDER_H
+#define PYRAMIDBUILDER_H
+
+// Parent class
+#include <QThread>
+
+// Implementation classes
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWaitCondition>
+
+#include "tilepyramid.h"
+
+/*
+ * Builds tile pyramids in the background. Only the latest requested image matters: requesting a new
+ * pyramid abandons the one being built
+ */
+class PyramidBuilder : public QThread {
+    Q_OBJECT
+
+private:
+    QMutex mutex;
+    QWaitCondition requested;
+    QImage pendingImage;
+    bool hasPending = false;
+    bool cancelled = false;
+    bool stopping = false;
+    QSharedPointer<TilePyramid> pyramid;
+
+    bool isCancelled();
+
+protected:
+    void run();
+
+public:
+    PyramidBuilder(QObject * parent = nullptr);
+    ~PyramidBuilder();
+
+    void build(const QImage & img);
+    void cancel();
+    QSharedPointer<TilePyramid> takePyramid();
+
+signals:
+    void pyramidBuilt();
+};
+
+#endif // PYRAMIDBUILDER_H
@@ -0,0 +1,100 @@
+#include "qualitygovernor.h"
+
+QualityGovernor::QualityGovernor()
+    : level(FULL) {
+}
+
+/*
+ * Start over at full quality (e.g. for a new webcam)
+ */
+void QualityGovernor::reset() {
+    level.store(FULL);
+    averageNs = 0;
+    slowFrames = 0;
+    fastFrames = 0;
+}
+
+/*
+ * Account for the time taken to process a frame, at the source's frame rate. Returns whether the level changed
+ */
+bool QualityGovernor::frameProcessed(qint64 processingNs, double fps) {
+    double targetNs = TARGET_LOAD * 1e9 / ((fps > 0) ? fps : DEFAULT_FPS);
+    averageNs = (averageNs == 0) ? processingNs : averageNs + SMOOTHING * (processingNs - averageNs);
+
+    Level curLevel = getLevel();
+    slowFrames = (averageNs > targetNs) ? slowFrames + 1 : 0;
+    fastFrames = (curLevel > FULL && averageNs * getCostRatio(curLevel) < targetNs) ? fastFrames + 1 : 0;
+
+    Level newLevel = curLevel;
+    if (slowFrames >= STEP_DOWN_FRAMES && curLevel < LEVEL_COUNT - 1) {
+        newLevel = Level(curLevel + 1);
+    }
+    else if (fastFrames >= STEP_UP_FRAMES) {
+        newLevel = Level(curLevel - 1);
+    }
+    if (newLevel == curLevel) {
+        return false;
+    }
+
+    // Measure the new level from scratch
+    level.store(newLevel);
+    averageNs = 0;
+    slowFrames = 0;
+    fastFrames = 0;
+
+    return true;
+}
+
+QualityGovernor::Level QualityGovernor::getLevel() const {
+    return Level(level.load());
+}
+
+/*
+ * Lower the quality of settings to the current level
+ */
+void QualityGovernor::apply(ImageSettings & settings) const {
+    Level curLevel = getLevel();
+    if (curLevel >= FAST_ROTATION) {
+        settings.interpolation = cv::INTER_NEAREST;
+    }
+    if (curLevel == HALF_RESOLUTION) {
+        settings.scale = 0.5;
+    }
+    else if (curLevel == QUARTER_RESOLUTION) {
+        settings.scale = 0.25;
+    }
+}
+
+const char * QualityGovernor::getLevelName(Level level) {
+    switch (level) {
+        case FULL :
+            return "Full";
+        case FAST_ROTATION :
+            return "Fast rotation";
+        case HALF_RESOLUTION :
+            return "Half resolution";
+        case QUARTER_RESOLUTION :
+            return "Quarter resolution";
+        case LEVEL_COUNT :
+        default:
+            return "";
+    }
+}
+
+/*
+ * About how many times longer processing takes at the level above this one
+ */
+double QualityGovernor::getCostRatio(Level level) {
+    switch (level) {
+        case FAST_ROTATION :
+            return 1.5;
+        case HALF_RESOLUTION :
+        case QUARTER_RESOLUTION :
+            // Four times the pixels
+            return 4;
+        case FULL :
+        case LEVEL_COUNT :
+        default:
+            return 1;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef QUALITYGOVERNOR_H
+#define QUALITYGOVERNOR_H
+
+// Implementation classes
+#include <atomic>
+
+#include <QtGlobal>
+
+#include <opencv2/imgproc.hpp>
+
+#include "imagesettings.h"
+
+/*
+ * Lowers the quality that video frames are processed at when processing can't keep up with the webcam,
+ * and raises it again once there is room. Processing time is smoothed over frames and compared with the
+ * time between frames; quality is only raised when the next level up is expected to fit, so that it
+ * doesn't go back and forth. Only used by the player thread (the level can be read from any thread)
+ */
+class QualityGovernor {
+
+public:
+    enum Level : int {
+        FULL = 0,
+        // Nearest neighbour instead of bilinear rotation
+        FAST_ROTATION = 1,
+        HALF_RESOLUTION = 2,
+        QUARTER_RESOLUTION = 3,
+        LEVEL_COUNT = 4,
+    };
+
+private:
+    std::atomic<int> level;
+    // Smoothed processing time at the current level (0 until the first frame)
+    double averageNs = 0;
+    int slowFrames = 0;
+    int fastFrames = 0;
+
+    static double getCostRatio(Level level);
+
+public:
+    // Share of the time between frames that processing should take at most
+    static constexpr double TARGET_LOAD = 0.8;
+    // Weight of each new frame in the smoothed processing time
+    static constexpr double SMOOTHING = 0.1;
+    // Frames in a row over (or under) target before the level changes
+    static const int STEP_DOWN_FRAMES = 15;
+    static const int STEP_UP_FRAMES = 90;
+    // Used when the source doesn't tell its frame rate
+    static constexpr double DEFAULT_FPS = 30;
+
+    QualityGovernor();
+
+    void reset();
+    bool frameProcessed(qint64 processingNs, double fps);
+    Level getLevel() const;
+    void apply(ImageSettings & settings) const;
+    static const char * getLevelName(Level level);
+};
+
+#endif // QUALITYGOVERNOR_H
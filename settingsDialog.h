@@ -5,7 +5,6 @@
 #include <QDialog>
 
 // Implementation classes
-#include <QCameraInfo>
 #include <QCheckBox>
 #include <QColorDialog>
 #include <QComboBox>
@@ -14,7 +13,6 @@
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QPushButton>
-#include <QSettings>
 #include <QSpinBox>
 #include <QSlider>
 #include <QVBoxLayout>
@@ -22,6 +20,8 @@
 #include <string>
 
 #include "colorbutton.h"
+#include "deviceregistry.h"
+#include "settingsmodel.h"
 
 class SettingsDialog : public QDialog {
 
@@ -40,6 +40,8 @@ private:
     QSpinBox * linePosBox;
     QSpinBox * lineThicknessBox;
     ColorButton * lineColorButton;
+    QSpinBox * maxFpsBox;
+    QSpinBox * historyMemoryBox;
 
 
     QPushButton * defaultButton;
@@ -50,34 +52,18 @@ private:
     QGridLayout * createSettingsLayout();
     QHBoxLayout * createButtonLayout();
 
-protected:
-    const double DEFAULT_BRIGHTNESS = 0;
-    const double DEFAULT_CONTRAST = 1;
-    const double DEFAULT_MIN_ZOOM = 1.0;
-    const double DEFAULT_MAX_ZOOM = 5;
-    const QString DEFAULT_FILTER = "None";
-    const int DEFAULT_ANGLE = 0;
-    const bool DEFAULT_CLICK_TO_DRAG = false;
-    const bool DEFAULT_IS_LINE_DRAWN = false;
-    const int DEFAULT_LINE_POS = 50;
-    const int DEFAULT_LINE_THICKNESS = 10;
-    const QColor DEFAULT_LINE_COLOR = Qt::red;
-
 public:
     SettingsDialog();
     SettingsDialog(QWidget * parent);
 
-signals:
-    // Indicates when temporary image display values change
-    void tempSettingsChanged();
-
 private slots:
     void changeLineEnabled(int state);
-    void changeTempImageSettings();
+    void previewSettings();
     void closeDialog();
     void saveAndCloseDialog();
     void restoreDefaults();
     void restoreWebcamDefault();
+    void updateWebcamList();
 
 };
 
@@ -11,6 +11,11 @@ SettingsDialog::SettingsDialog(QWidget * parent)
 
     setLayout(dialogLayout);
     setWindowTitle(tr("Advanced Settings"));
+
+    // Changes are previewed until accepted, and undone otherwise (including closing the window)
+    SettingsModel * model = SettingsModel::instance();
+    model->beginEditing();
+    connect(this, SIGNAL (rejected()), model, SLOT (revertEditing()));
 }
 
 /*
@@ -31,78 +36,28 @@ void SettingsDialog::changeLineEnabled(int state) {
             break;
     }
 
-    changeTempImageSettings();
+    previewSettings();
 }
 
 /*
- * Save temporary settings for dynamically modifying image settings
+ * Preview image and guiding line settings while they are being chosen
  */
-void SettingsDialog::changeTempImageSettings() {
-
-    bool isLineDrawn;
-    switch (guidingLineBox->checkState()) {
-        case Qt::Checked:
-            isLineDrawn = true;
-            break;
-        case Qt::Unchecked:
-        default:
-            isLineDrawn = false;
-        break;
-    }
-
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
-    settings.setValue("image/tempBrightness", double(brightnessSlider->value()) );
-    settings.setValue("image/tempContrast", double(contrastSlider->value()) / 100 );
-    settings.setValue("image/tempColorFilter", colorFilterBox->currentText() );
-    settings.setValue("image/tempAngle", rotateAngleBox->cleanText().toInt() );
-    settings.setValue("controls/tempIsLineDrawn", isLineDrawn);
-    settings.setValue("controls/tempLinePos", linePosBox->cleanText().toInt());
-    settings.setValue("controls/tempLineThickness", lineThicknessBox->cleanText().toInt());
-    settings.setValue("controls/tempLineColor", lineColorButton->getColor().name());
-
-    emit tempSettingsChanged();
+void SettingsDialog::previewSettings() {
+    SettingsModel * model = SettingsModel::instance();
+    model->setBrightness( double(brightnessSlider->value()) );
+    model->setContrast( double(contrastSlider->value()) / 100 ); // Divide by 100 to convert from int scale to double
+    model->setColorFilter( colorFilterBox->currentText() );
+    model->setAngle( rotateAngleBox->cleanText().toInt() );
+    model->setLineDrawn( guidingLineBox->checkState() == Qt::Checked );
+    model->setLinePos( linePosBox->cleanText().toInt() );
+    model->setLineThickness( lineThicknessBox->cleanText().toInt() );
+    model->setLineColor( lineColorButton->getColor() );
 }
 
 /*
- * Revert unsaved chantes and close dialog box
+ * Revert unsaved changes and close dialog box
  */
 void SettingsDialog::closeDialog() {
-
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
-    if (settings.contains("image/brightness")) {
-        settings.setValue("image/tempBrightness", settings.value("image/brightness").toDouble() );
-    }
-
-    if (settings.contains("image/contrast")) {
-        settings.setValue("image/tempContrast", settings.value("image/contrast").toDouble() );
-    }
-
-    if (settings.contains("image/colorFilter")) {
-        settings.setValue("image/tempColorFilter", settings.value("image/colorFilter").toString() );
-    }
-
-    if (settings.contains("image/angle")) {
-        settings.setValue("image/tempAngle", settings.value("image/angle").toInt() );
-    }
-
-    if (settings.contains("controls/isLineDrawn")) {
-        settings.setValue("controls/tempIsLineDrawn", settings.value("controls/isLineDrawn").toBool() );
-    }
-
-    if (settings.contains("controls/linePos")) {
-        settings.setValue("controls/tempLinePos", settings.value("controls/linePos").toInt() );
-    }
-
-    if (settings.contains("controls/lineThickness")) {
-        settings.setValue("controls/tempLineThickness", settings.value("controls/lineThickness").toString() );
-    }
-
-    if (settings.contains("controls/lineColor")) {
-        settings.setValue("controls/tempLineColor", settings.value("controls/lineColor").toString() );
-    }
-
-    emit tempSettingsChanged();
-
     // Emit "rejected" signal (settings not changed) and hide window
     this->reject();
     this->close();
@@ -128,7 +83,7 @@ QVBoxLayout * SettingsDialog::createDialogLayout() {
  */
 QGridLayout * SettingsDialog::createSettingsLayout() {
     QGridLayout * settingsLayout = new QGridLayout(this);
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
+    SettingsModel * model = SettingsModel::instance();
 
     // Create brightness and contrast sliders that vary from 1 to 100, ticks every quarter, starting in the middle.
     brightnessSlider = new QSlider(Qt::Horizontal, this);
@@ -140,11 +95,8 @@ QGridLayout * SettingsDialog::createSettingsLayout() {
     brightnessSlider->setSingleStep(1);
     brightnessSlider->setPageStep( int((brightnessSlider->maximum() - brightnessSlider->minimum()) / 10) );
 
-    // Set brightness slider to previous position, or default if else
-    int brightnessSliderPos = ( settings.contains("image/brightness") )
-            ? int(settings.value("image/brightness").toDouble())
-            : int(DEFAULT_BRIGHTNESS);
-    brightnessSlider->setSliderPosition( brightnessSliderPos );
+    // Set brightness slider to previous position
+    brightnessSlider->setSliderPosition( int(model->getBrightness()) );
 
     contrastSlider = new QSlider(Qt::Horizontal, this);
     contrastSlider->setTickPosition(QSlider::TicksAbove);
@@ -155,23 +107,11 @@ QGridLayout * SettingsDialog::createSettingsLayout() {
     contrastSlider->setSingleStep(1);
     contrastSlider->setPageStep(50);
 
-    // Set contrast slider to previous position, or default if else
-    int contrastSliderPos = ( settings.contains("image/contrast") )
-            ? int(settings.value("image/contrast").toDouble() * 100)
-            : int(DEFAULT_CONTRAST * 100); // Multiply by 100 to convert from double to int scale
-    contrastSlider->setSliderPosition( contrastSliderPos );
+    // Set contrast slider to previous position
+    contrastSlider->setSliderPosition( int(model->getContrast() * 100) ); // Multiply by 100 to convert from double to int scale
 
-    // Drop-down list of available webcams
+    // Drop-down list of available webcams (filled in once they are enumerated, and again when they change)
     webcamBox = new QComboBox(this);
-    QList<QCameraInfo> webcams = QCameraInfo::availableCameras();
-    QList<QString> webcamNames = {};
-    if (webcams.count() > 0) {
-        // Get list of webcams
-        for (QCameraInfo & webcamInfo : webcams) {
-            webcamNames << webcamInfo.description();
-        }
-    }
-    webcamBox->addItems(webcamNames);
 
     // Spin box for color filter choice
     colorFilterBox = new QComboBox(this);
@@ -181,8 +121,7 @@ QGridLayout * SettingsDialog::createSettingsLayout() {
 
     rotateAngleBox = new QSpinBox(this);
     rotateAngleBox->setRange(0, 360);
-    int curAngle = (settings.contains("image/angle")) ? settings.value("image/angle").toInt() : DEFAULT_ANGLE;
-    rotateAngleBox->setValue(curAngle);
+    rotateAngleBox->setValue( model->getAngle() );
     rotateAngleBox->setSingleStep(5);
     rotateAngleBox->setSuffix("°");
 
@@ -190,33 +129,29 @@ QGridLayout * SettingsDialog::createSettingsLayout() {
 
     minZoomBox = new QDoubleSpinBox(this);
     minZoomBox->setRange(0.1,1.0);
-    double curMinZoom = (settings.contains("image/minZoom")) ? settings.value("image/minZoom").toDouble() : DEFAULT_MIN_ZOOM;
-    minZoomBox->setValue( curMinZoom );
+    minZoomBox->setValue( model->getMinZoom() );
     minZoomBox->setDecimals(1);
     minZoomBox->setSingleStep(0.1);
     minZoomBox->setSuffix("x");
 
     maxZoomBox = new QSpinBox(this);
     maxZoomBox->setRange(2, 20);
-    int curMaxZoom = (settings.contains("image/maxZoom")) ? settings.value("image/maxZoom").toInt() : int(DEFAULT_MAX_ZOOM);
-    maxZoomBox->setValue(curMaxZoom);
+    maxZoomBox->setValue( model->getMaxZoom() );
     maxZoomBox->setSingleStep(1);
     maxZoomBox->setSuffix("x");  
 
     clickDragBox = new QCheckBox(this);
-    bool isClickToDrag = (settings.contains("controls/clickToDrag")) ? settings.value("controls/clickToDrag").toBool() : DEFAULT_CLICK_TO_DRAG;
-    clickDragBox->setCheckState( (isClickToDrag) ? Qt::Checked : Qt::Unchecked);
+    clickDragBox->setCheckState( (model->isClickToDrag()) ? Qt::Checked : Qt::Unchecked);
 
     // Check box whether guiding line is on or off
     guidingLineBox = new QCheckBox(this);
-    bool isLineDrawn = (settings.contains("controls/isLineDrawn")) ? settings.value("controls/isLineDrawn").toBool() : DEFAULT_IS_LINE_DRAWN;
+    bool isLineDrawn = model->isLineDrawn();
     guidingLineBox->setCheckState( (isLineDrawn) ? Qt::Checked : Qt::Unchecked);
 
     // Position of guiding line
     linePosBox = new QSpinBox(this);
     linePosBox->setRange(0, 100);
-    int curLinePos = (settings.contains("controls/linePos")) ? settings.value("controls/linePos").toInt() : DEFAULT_LINE_POS;
-    linePosBox->setValue(curLinePos);
+    linePosBox->setValue( model->getLinePos() );
     linePosBox->setSingleStep(5);
     linePosBox->setSuffix("%");
     if (!isLineDrawn || !guidingLineBox->isEnabled()) {
@@ -225,43 +160,42 @@ QGridLayout * SettingsDialog::createSettingsLayout() {
 
     lineThicknessBox = new QSpinBox(this);
     lineThicknessBox->setRange(1, 50);
-    int curLineThickness = (settings.contains("controls/lineThickness")) ? settings.value("controls/lineThickness").toInt() : DEFAULT_LINE_THICKNESS;
-    lineThicknessBox->setValue(curLineThickness);
+    lineThicknessBox->setValue( model->getLineThickness() );
     lineThicknessBox->setSingleStep(1);
     lineThicknessBox->setSuffix(" pixels");
     if (!isLineDrawn || !guidingLineBox->isEnabled()) {
         lineThicknessBox->setEnabled(false);
     }
 
+    // Spin box for the video frame rate cap, where 0 follows the display
+    maxFpsBox = new QSpinBox(this);
+    maxFpsBox->setRange(0, 240);
+    maxFpsBox->setValue( model->getMaxFps() );
+    maxFpsBox->setSingleStep(5);
+    maxFpsBox->setSuffix(" fps");
+    maxFpsBox->setSpecialValueText("Display refresh rate");
+
+    // Spin box for memory kept by snapshot history before it moves to disk
+    historyMemoryBox = new QSpinBox(this);
+    historyMemoryBox->setRange(16, 4096);
+    historyMemoryBox->setValue( model->getHistoryMemory() );
+    historyMemoryBox->setSingleStep(64);
+    historyMemoryBox->setSuffix(" MB");
 
     // Button that chooses color of guiding line
-    QString curLineColorName = (settings.contains("controls/lineColor")) ? settings.value("controls/lineColor").toString() : DEFAULT_LINE_COLOR.name();
-    QColor curColor = QColor(curLineColorName);
-    if (!curColor.isValid()) {
-        curColor = DEFAULT_LINE_COLOR;
-    }
-    lineColorButton = new ColorButton(curColor, this);
+    lineColorButton = new ColorButton(model->getLineColor(), this);
     if (!isLineDrawn || !guidingLineBox->isEnabled()) {
         lineColorButton->setEnabled(false);
     }
 
     // Set default to previously used webcam, or to system's default webcam, or first index if else
-    if (settings.contains("webcam/deviceIndex") && settings.value("webcam/deviceIndex").toInt() < webcamBox->count()) {
-        webcamBox->setCurrentIndex( settings.value("webcam/deviceIndex").toInt() );
-    }
-    else {
-        restoreWebcamDefault();
-    }
+    DeviceRegistry * registry = DeviceRegistry::instance();
+    updateWebcamList();
+    connect(registry, SIGNAL (devicesChanged()), this, SLOT (updateWebcamList()));
+    registry->refresh();
 
     // Set default to previously used filter or to default filter.
-    QString curFilter;
-    if (settings.contains("image/colorFilter")) {
-        curFilter = settings.value("image/colorFilter").toString();
-    }
-    else {
-        curFilter = DEFAULT_FILTER;
-    }
-    int curFilterIndex = colorFilterBox->findText(curFilter);
+    int curFilterIndex = colorFilterBox->findText( model->getColorFilter() );
     colorFilterBox->setCurrentIndex( curFilterIndex );
 
     // Construct UI layout for each row
@@ -338,17 +272,27 @@ QGridLayout * SettingsDialog::createSettingsLayout() {
     settingsLayout->addWidget(lineThicknessLabel, 11, 0, 1, 2, Qt::AlignLeft);
     settingsLayout->addWidget(lineThicknessBox, 11, 2, 1, 12);
 
+    // Row 13: Video frame rate
+    QLabel * maxFpsLabel = new QLabel("Max Frame Rate:", this);
+    settingsLayout->addWidget(maxFpsLabel, 12, 0, 1, 2, Qt::AlignLeft);
+    settingsLayout->addWidget(maxFpsBox, 12, 2, 1, 12);
+
+    // Row 14: Snapshot history memory
+    QLabel * historyMemoryLabel = new QLabel("Snapshot History Memory:", this);
+    settingsLayout->addWidget(historyMemoryLabel, 13, 0, 1, 2, Qt::AlignLeft);
+    settingsLayout->addWidget(historyMemoryBox, 13, 2, 1, 12);
+
     // Modify settings dynamically when value changes
     brightnessSlider->setTracking(true);
     contrastSlider->setTracking(true);
-    connect(brightnessSlider, SIGNAL (valueChanged(int)), this, SLOT (changeTempImageSettings()), Qt::QueuedConnection );
-    connect(contrastSlider, SIGNAL (valueChanged(int)), this, SLOT (changeTempImageSettings()), Qt::QueuedConnection );
-    connect(colorFilterBox, SIGNAL (currentTextChanged(QString)), this, SLOT (changeTempImageSettings()), Qt::QueuedConnection );
-    connect(rotateAngleBox, SIGNAL (valueChanged(int)), this, SLOT (changeTempImageSettings()), Qt::QueuedConnection );
+    connect(brightnessSlider, SIGNAL (valueChanged(int)), this, SLOT (previewSettings()), Qt::QueuedConnection );
+    connect(contrastSlider, SIGNAL (valueChanged(int)), this, SLOT (previewSettings()), Qt::QueuedConnection );
+    connect(colorFilterBox, SIGNAL (currentTextChanged(QString)), this, SLOT (previewSettings()), Qt::QueuedConnection );
+    connect(rotateAngleBox, SIGNAL (valueChanged(int)), this, SLOT (previewSettings()), Qt::QueuedConnection );
     connect(guidingLineBox, SIGNAL (stateChanged(int)), this, SLOT (changeLineEnabled(int)), Qt::QueuedConnection );
-    connect(linePosBox, SIGNAL (valueChanged(int)), this, SLOT (changeTempImageSettings()), Qt::QueuedConnection );
-    connect(lineThicknessBox, SIGNAL (valueChanged(int)), this, SLOT (changeTempImageSettings()), Qt::QueuedConnection );
-    connect(lineColorButton, SIGNAL (colorChanged(QColor)), this, SLOT (changeTempImageSettings()), Qt::QueuedConnection );
+    connect(linePosBox, SIGNAL (valueChanged(int)), this, SLOT (previewSettings()), Qt::QueuedConnection );
+    connect(lineThicknessBox, SIGNAL (valueChanged(int)), this, SLOT (previewSettings()), Qt::QueuedConnection );
+    connect(lineColorButton, SIGNAL (colorChanged(QColor)), this, SLOT (previewSettings()), Qt::QueuedConnection );
 
     return settingsLayout;
 }
@@ -389,81 +333,72 @@ QHBoxLayout * SettingsDialog::createButtonLayout() {
 void SettingsDialog::restoreDefaults() {
     restoreWebcamDefault();
 
-    brightnessSlider->setSliderPosition( int(DEFAULT_BRIGHTNESS) );
-    contrastSlider->setSliderPosition( int(DEFAULT_CONTRAST * 100) );
-    rotateAngleBox->setValue(DEFAULT_ANGLE);
-    minZoomBox->setValue( DEFAULT_MIN_ZOOM );
-    maxZoomBox->setValue( int(DEFAULT_MAX_ZOOM) );
-    colorFilterBox->setCurrentIndex( colorFilterBox->findText(DEFAULT_FILTER) );
-    clickDragBox->setCheckState( (DEFAULT_CLICK_TO_DRAG) ? Qt::Checked : Qt::Unchecked);
-    guidingLineBox->setCheckState( (DEFAULT_IS_LINE_DRAWN) ? Qt::Checked : Qt::Unchecked);
-    linePosBox->setValue(DEFAULT_LINE_POS);
-    lineThicknessBox->setValue(DEFAULT_LINE_THICKNESS);
-    lineColorButton->setColor(DEFAULT_LINE_COLOR);
+    brightnessSlider->setSliderPosition( int(SettingsModel::DEFAULT_BRIGHTNESS) );
+    contrastSlider->setSliderPosition( int(SettingsModel::DEFAULT_CONTRAST * 100) );
+    rotateAngleBox->setValue(SettingsModel::DEFAULT_ANGLE);
+    minZoomBox->setValue( SettingsModel::DEFAULT_MIN_ZOOM );
+    maxZoomBox->setValue( SettingsModel::DEFAULT_MAX_ZOOM );
+    colorFilterBox->setCurrentIndex( colorFilterBox->findText(SettingsModel::DEFAULT_FILTER) );
+    clickDragBox->setCheckState( (SettingsModel::DEFAULT_CLICK_TO_DRAG) ? Qt::Checked : Qt::Unchecked);
+    guidingLineBox->setCheckState( (SettingsModel::DEFAULT_IS_LINE_DRAWN) ? Qt::Checked : Qt::Unchecked);
+    linePosBox->setValue(SettingsModel::DEFAULT_LINE_POS);
+    lineThicknessBox->setValue(SettingsModel::DEFAULT_LINE_THICKNESS);
+    lineColorButton->setColor(SettingsModel::DEFAULT_LINE_COLOR);
+    maxFpsBox->setValue(SettingsModel::DEFAULT_MAX_FPS);
+    historyMemoryBox->setValue(SettingsModel::DEFAULT_HISTORY_MEMORY);
 }
 
 /*
  * Find system default webcam in list (if not found, first index).
  */
 void SettingsDialog::restoreWebcamDefault() {
-    QList<QCameraInfo> webcams = QCameraInfo::availableCameras();
-
-    if (!QCameraInfo::defaultCamera().isNull()) {
-        for (int i = 0; i < webcams.count(); i++) {
-            if (webcams[i] == QCameraInfo::defaultCamera()) {
-                webcamBox->setCurrentIndex(i);
-                break;
-            }
-        }
+    int defaultIndex = webcamBox->findData( DeviceRegistry::instance()->getDefaultId() );
+    webcamBox->setCurrentIndex( (defaultIndex >= 0) ? defaultIndex : 0 );
+}
+
+/*
+ * List webcams that are connected, keeping the selected webcam (or the one in settings) selected
+ */
+void SettingsDialog::updateWebcamList() {
+    QString selectedId = (webcamBox->count() > 0)
+            ? webcamBox->currentData().toString()
+            : SettingsModel::instance()->getDeviceId();
+
+    webcamBox->clear();
+    for (const DeviceRegistry::Device & device : DeviceRegistry::instance()->getDevices()) {
+        webcamBox->addItem(device.name, device.id);
+    }
+
+    int selectedIndex = webcamBox->findData(selectedId);
+    if (selectedIndex >= 0) {
+        webcamBox->setCurrentIndex(selectedIndex);
     }
     else {
-        webcamBox->setCurrentIndex(0);
+        restoreWebcamDefault();
     }
 }
 
 /*
- * Emit that image settings have changed and close dialog box.
+ * Keep the chosen settings and close dialog box.
  */
 void SettingsDialog::saveAndCloseDialog() {
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
-
-    bool isClickToDragChecked;
-    switch (clickDragBox->checkState()) {
-        case Qt::Checked:
-            isClickToDragChecked = true;
-            break;
-        case Qt::Unchecked:
-        default:
-            isClickToDragChecked = false;
-            break;
-    }
-
-    bool isLineDrawn;
-    switch (guidingLineBox->checkState()) {
-        case Qt::Checked:
-            isLineDrawn = true;
-            break;
-        case Qt::Unchecked:
-        default:
-            isLineDrawn = false;
-        break;
+    // Image and guiding line settings are already up to date from previewing them
+    SettingsModel * model = SettingsModel::instance();
+    if (webcamBox->count() > 0) {
+        QString deviceId = webcamBox->currentData().toString();
+        int deviceIndex = DeviceRegistry::instance()->findIndex(deviceId);
+        if (deviceIndex >= 0) {
+            model->setDeviceIndex(deviceIndex);
+        }
+        model->setDeviceName( webcamBox->currentText() );
+        model->setDeviceId(deviceId);
     }
-
-    // Save settings in native format (Windows: registry, Other: config file)
-    settings.setValue("webcam/deviceIndex", webcamBox->currentIndex());
-    settings.setValue("webcam/deviceName", webcamBox->currentText());
-    settings.setValue("image/brightness", double(brightnessSlider->value()));
-    settings.setValue("image/contrast", double(contrastSlider->value()) / 100 ); // Divide by 100 to convert from int scale to double
-    settings.setValue("image/angle", rotateAngleBox->cleanText().toInt());
-    settings.setValue("image/minZoom", minZoomBox->cleanText().toDouble() );
-    settings.setValue("image/maxZoom", maxZoomBox->cleanText().toDouble() );
-    settings.setValue("image/colorFilter", colorFilterBox->currentText());
-    settings.setValue("controls/clickToDrag", isClickToDragChecked);
-    settings.setValue("controls/isLineDrawn", isLineDrawn);
-    settings.setValue("controls/linePos", linePosBox->cleanText().toInt());
-    settings.setValue("controls/lineThickness", lineThicknessBox->cleanText().toInt());
-    settings.setValue("controls/lineColor", lineColorButton->getColor().name());
-
+    model->setMinZoom( minZoomBox->cleanText().toDouble() );
+    model->setMaxZoom( maxZoomBox->cleanText().toInt() );
+    model->setClickToDrag( clickDragBox->checkState() == Qt::Checked );
+    model->setMaxFps( maxFpsBox->value() );
+    model->setHistoryMemory( historyMemoryBox->value() );
+    model->commitEditing();
 
     // Emit "accepted" signal (settings changed) and hide window
     this->accept();
@@ -0,0 +1,344 @@
+#include "settingsmodel.h"
+
+constexpr double SettingsModel::DEFAULT_BRIGHTNESS;
+constexpr double SettingsModel::DEFAULT_CONTRAST;
+constexpr double SettingsModel::DEFAULT_MIN_ZOOM;
+const QString SettingsModel::DEFAULT_FILTER = "None";
+const QColor SettingsModel::DEFAULT_LINE_COLOR = Qt::red;
+
+/*
+ * Settings shared by the whole application (read from native storage the first time)
+ */
+SettingsModel * SettingsModel::instance() {
+    static SettingsModel * model = nullptr;
+    if (model == nullptr) {
+        model = new SettingsModel(QCoreApplication::instance());
+    }
+
+    return model;
+}
+
+SettingsModel::SettingsModel(QObject * parent)
+    : QObject(parent) {
+    load();
+
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(SAVE_DELAY_MS);
+    connect(&saveTimer, SIGNAL (timeout()), this, SLOT (save()));
+}
+
+/*
+ * Read settings from native storage (Windows: registry, Other: config file), keeping defaults for missing ones
+ */
+void SettingsModel::load() {
+    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
+
+    values.brightness = settings.value("image/brightness", DEFAULT_BRIGHTNESS).toDouble();
+    values.contrast = settings.value("image/contrast", DEFAULT_CONTRAST).toDouble();
+    values.colorFilter = settings.value("image/colorFilter", DEFAULT_FILTER).toString();
+    values.angle = settings.value("image/angle", DEFAULT_ANGLE).toInt();
+    values.minZoom = settings.value("image/minZoom", DEFAULT_MIN_ZOOM).toDouble();
+    values.maxZoom = settings.value("image/maxZoom", DEFAULT_MAX_ZOOM).toInt();
+    values.clickToDrag = settings.value("controls/clickToDrag", DEFAULT_CLICK_TO_DRAG).toBool();
+    values.lineDrawn = settings.value("controls/isLineDrawn", DEFAULT_IS_LINE_DRAWN).toBool();
+    values.linePos = settings.value("controls/linePos", DEFAULT_LINE_POS).toInt();
+    values.lineThickness = settings.value("controls/lineThickness", DEFAULT_LINE_THICKNESS).toInt();
+    values.maxFps = settings.value("video/maxFps", DEFAULT_MAX_FPS).toInt();
+    values.historyMemory = settings.value("snapshot/historyMemory", DEFAULT_HISTORY_MEMORY).toInt();
+    values.deviceIndex = settings.value("webcam/deviceIndex", DEFAULT_DEVICE).toInt();
+    values.deviceName = settings.value("webcam/deviceName", "").toString();
+    values.deviceId = settings.value("webcam/deviceId", "").toString();
+
+    QColor lineColor = QColor( settings.value("controls/lineColor", DEFAULT_LINE_COLOR.name()).toString() );
+    values.lineColor = lineColor.isValid() ? lineColor : DEFAULT_LINE_COLOR;
+
+    committedValues = values;
+}
+
+/*
+ * Write every setting to native storage at once
+ */
+void SettingsModel::save() {
+    saveTimer.stop();
+
+    // Only committed values are saved, never the ones being previewed
+    const Values & saved = editing ? committedValues : values;
+
+    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
+    settings.setValue("webcam/deviceIndex", saved.deviceIndex);
+    settings.setValue("webcam/deviceName", saved.deviceName);
+    settings.setValue("webcam/deviceId", saved.deviceId);
+    settings.setValue("image/brightness", saved.brightness);
+    settings.setValue("image/contrast", saved.contrast);
+    settings.setValue("image/angle", saved.angle);
+    settings.setValue("image/minZoom", saved.minZoom);
+    settings.setValue("image/maxZoom", saved.maxZoom);
+    settings.setValue("image/colorFilter", saved.colorFilter);
+    settings.setValue("controls/clickToDrag", saved.clickToDrag);
+    settings.setValue("controls/isLineDrawn", saved.lineDrawn);
+    settings.setValue("controls/linePos", saved.linePos);
+    settings.setValue("controls/lineThickness", saved.lineThickness);
+    settings.setValue("controls/lineColor", saved.lineColor.name());
+    settings.setValue("video/maxFps", saved.maxFps);
+    settings.setValue("snapshot/historyMemory", saved.historyMemory);
+}
+
+/*
+ * Save once settings stop changing, unless they are only being previewed
+ */
+void SettingsModel::scheduleSave() {
+    if (!editing) {
+        saveTimer.start();
+    }
+}
+
+/*
+ * Start previewing changes, which can be committed or reverted afterwards
+ */
+void SettingsModel::beginEditing() {
+    committedValues = values;
+    editing = true;
+}
+
+/*
+ * Keep previewed changes and save them
+ */
+void SettingsModel::commitEditing() {
+    editing = false;
+    committedValues = values;
+    scheduleSave();
+}
+
+/*
+ * Restore settings from before editing started
+ */
+void SettingsModel::revertEditing() {
+    setValues(committedValues);
+    editing = false;
+}
+
+/*
+ * Change every setting, notifying about the ones that are different
+ */
+void SettingsModel::setValues(const Values & newValues) {
+    setBrightness(newValues.brightness);
+    setContrast(newValues.contrast);
+    setColorFilter(newValues.colorFilter);
+    setAngle(newValues.angle);
+    setMinZoom(newValues.minZoom);
+    setMaxZoom(newValues.maxZoom);
+    setClickToDrag(newValues.clickToDrag);
+    setLineDrawn(newValues.lineDrawn);
+    setLinePos(newValues.linePos);
+    setLineThickness(newValues.lineThickness);
+    setLineColor(newValues.lineColor);
+    setMaxFps(newValues.maxFps);
+    setHistoryMemory(newValues.historyMemory);
+    setDeviceIndex(newValues.deviceIndex);
+    setDeviceName(newValues.deviceName);
+    setDeviceId(newValues.deviceId);
+}
+
+double SettingsModel::getBrightness() const {
+    return values.brightness;
+}
+
+void SettingsModel::setBrightness(double brightness) {
+    if (values.brightness != brightness) {
+        values.brightness = brightness;
+        scheduleSave();
+        emit brightnessChanged(brightness);
+    }
+}
+
+double SettingsModel::getContrast() const {
+    return values.contrast;
+}
+
+void SettingsModel::setContrast(double contrast) {
+    if (values.contrast != contrast) {
+        values.contrast = contrast;
+        scheduleSave();
+        emit contrastChanged(contrast);
+    }
+}
+
+QString SettingsModel::getColorFilter() const {
+    return values.colorFilter;
+}
+
+void SettingsModel::setColorFilter(const QString & colorFilter) {
+    if (values.colorFilter != colorFilter) {
+        values.colorFilter = colorFilter;
+        scheduleSave();
+        emit colorFilterChanged(colorFilter);
+    }
+}
+
+int SettingsModel::getAngle() const {
+    return values.angle;
+}
+
+void SettingsModel::setAngle(int angle) {
+    if (values.angle != angle) {
+        values.angle = angle;
+        scheduleSave();
+        emit angleChanged(angle);
+    }
+}
+
+double SettingsModel::getMinZoom() const {
+    return values.minZoom;
+}
+
+void SettingsModel::setMinZoom(double minZoom) {
+    if (values.minZoom != minZoom) {
+        values.minZoom = minZoom;
+        scheduleSave();
+        emit minZoomChanged(minZoom);
+    }
+}
+
+int SettingsModel::getMaxZoom() const {
+    return values.maxZoom;
+}
+
+void SettingsModel::setMaxZoom(int maxZoom) {
+    if (values.maxZoom != maxZoom) {
+        values.maxZoom = maxZoom;
+        scheduleSave();
+        emit maxZoomChanged(maxZoom);
+    }
+}
+
+bool SettingsModel::isClickToDrag() const {
+    return values.clickToDrag;
+}
+
+void SettingsModel::setClickToDrag(bool clickToDrag) {
+    if (values.clickToDrag != clickToDrag) {
+        values.clickToDrag = clickToDrag;
+        scheduleSave();
+        emit clickToDragChanged(clickToDrag);
+    }
+}
+
+bool SettingsModel::isLineDrawn() const {
+    return values.lineDrawn;
+}
+
+void SettingsModel::setLineDrawn(bool lineDrawn) {
+    if (values.lineDrawn != lineDrawn) {
+        values.lineDrawn = lineDrawn;
+        scheduleSave();
+        emit lineDrawnChanged(lineDrawn);
+    }
+}
+
+/*
+ * Position of guiding line as percentage of height (0% is bottom, 100% is top)
+ */
+int SettingsModel::getLinePos() const {
+    return values.linePos;
+}
+
+void SettingsModel::setLinePos(int linePos) {
+    if (values.linePos != linePos) {
+        values.linePos = linePos;
+        scheduleSave();
+        emit linePosChanged(linePos);
+    }
+}
+
+int SettingsModel::getLineThickness() const {
+    return values.lineThickness;
+}
+
+void SettingsModel::setLineThickness(int lineThickness) {
+    if (values.lineThickness != lineThickness) {
+        values.lineThickness = lineThickness;
+        scheduleSave();
+        emit lineThicknessChanged(lineThickness);
+    }
+}
+
+int SettingsModel::getMaxFps() const {
+    return values.maxFps;
+}
+
+void SettingsModel::setMaxFps(int maxFps) {
+    if (values.maxFps != maxFps) {
+        values.maxFps = maxFps;
+        scheduleSave();
+        emit maxFpsChanged(maxFps);
+    }
+}
+
+int SettingsModel::getHistoryMemory() const {
+    return values.historyMemory;
+}
+
+void SettingsModel::setHistoryMemory(int historyMemory) {
+    if (values.historyMemory != historyMemory) {
+        values.historyMemory = historyMemory;
+        scheduleSave();
+        emit historyMemoryChanged(historyMemory);
+    }
+}
+
+QColor SettingsModel::getLineColor() const {
+    return values.lineColor;
+}
+
+void SettingsModel::setLineColor(const QColor & lineColor) {
+    if (values.lineColor != lineColor) {
+        values.lineColor = lineColor;
+        scheduleSave();
+        emit lineColorChanged(lineColor);
+    }
+}
+
+int SettingsModel::getDeviceIndex() const {
+    return values.deviceIndex;
+}
+
+void SettingsModel::setDeviceIndex(int deviceIndex) {
+    if (values.deviceIndex != deviceIndex) {
+        values.deviceIndex = deviceIndex;
+        scheduleSave();
+        emit deviceIndexChanged(deviceIndex);
+    }
+}
+
+QString SettingsModel::getDeviceName() const {
+    return values.deviceName;
+}
+
+void SettingsModel::setDeviceName(const QString & deviceName) {
+    if (values.deviceName != deviceName) {
+        values.deviceName = deviceName;
+        scheduleSave();
+        emit deviceNameChanged(deviceName);
+    }
+}
+
+QString SettingsModel::getDeviceId() const {
+    return values.deviceId;
+}
+
+void SettingsModel::setDeviceId(const QString & deviceId) {
+    if (values.deviceId != deviceId) {
+        values.deviceId = deviceId;
+        scheduleSave();
+        emit deviceIdChanged(deviceId);
+    }
+}
+
+/*
+ * Write settings that are still waiting to be saved
+ */
+SettingsModel::~SettingsModel() {
+    if (saveTimer.isActive()) {
+        save();
+    }
+}
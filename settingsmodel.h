@@ -0,0 +1,155 @@
+#ifndef SETTINGSMODEL_H
+#define SETTINGSMODEL_H
+
+// Parent class
+#include <QObject>
+
+// Implementation classes
+#include <QColor>
+#include <QCoreApplication>
+#include <QSettings>
+#include <QString>
+#include <QTimer>
+
+/*
+ * Every user setting, kept in memory with a change signal per setting. Settings are read from native
+ * storage once, and written back in a single batch shortly after they stop changing. While the settings
+ * dialog is editing, changes are only previewed and nothing is written until they are committed
+ */
+class SettingsModel : public QObject {
+    Q_OBJECT
+
+    Q_PROPERTY(double brightness READ getBrightness WRITE setBrightness NOTIFY brightnessChanged)
+    Q_PROPERTY(double contrast READ getContrast WRITE setContrast NOTIFY contrastChanged)
+    Q_PROPERTY(QString colorFilter READ getColorFilter WRITE setColorFilter NOTIFY colorFilterChanged)
+    Q_PROPERTY(int angle READ getAngle WRITE setAngle NOTIFY angleChanged)
+    Q_PROPERTY(double minZoom READ getMinZoom WRITE setMinZoom NOTIFY minZoomChanged)
+    Q_PROPERTY(int maxZoom READ getMaxZoom WRITE setMaxZoom NOTIFY maxZoomChanged)
+    Q_PROPERTY(bool clickToDrag READ isClickToDrag WRITE setClickToDrag NOTIFY clickToDragChanged)
+    Q_PROPERTY(bool lineDrawn READ isLineDrawn WRITE setLineDrawn NOTIFY lineDrawnChanged)
+    Q_PROPERTY(int linePos READ getLinePos WRITE setLinePos NOTIFY linePosChanged)
+    Q_PROPERTY(int lineThickness READ getLineThickness WRITE setLineThickness NOTIFY lineThicknessChanged)
+    Q_PROPERTY(QColor lineColor READ getLineColor WRITE setLineColor NOTIFY lineColorChanged)
+    Q_PROPERTY(int maxFps READ getMaxFps WRITE setMaxFps NOTIFY maxFpsChanged)
+    Q_PROPERTY(int historyMemory READ getHistoryMemory WRITE setHistoryMemory NOTIFY historyMemoryChanged)
+    Q_PROPERTY(int deviceIndex READ getDeviceIndex WRITE setDeviceIndex NOTIFY deviceIndexChanged)
+    Q_PROPERTY(QString deviceName READ getDeviceName WRITE setDeviceName NOTIFY deviceNameChanged)
+    Q_PROPERTY(QString deviceId READ getDeviceId WRITE setDeviceId NOTIFY deviceIdChanged)
+
+public:
+    static constexpr double DEFAULT_BRIGHTNESS = 0;
+    static constexpr double DEFAULT_CONTRAST = 1;
+    static constexpr double DEFAULT_MIN_ZOOM = 1.0;
+    static const int DEFAULT_MAX_ZOOM = 5;
+    static const QString DEFAULT_FILTER;
+    static const int DEFAULT_ANGLE = 0;
+    static const bool DEFAULT_CLICK_TO_DRAG = false;
+    static const bool DEFAULT_IS_LINE_DRAWN = false;
+    static const int DEFAULT_LINE_POS = 50;
+    static const int DEFAULT_LINE_THICKNESS = 10;
+    static const QColor DEFAULT_LINE_COLOR;
+    static const int DEFAULT_DEVICE = 0;
+    // Live video frame rate cap (0 follows the display's refresh rate)
+    static const int DEFAULT_MAX_FPS = 0;
+    // Memory (in MB) that compressed snapshots in the history can use before moving to disk
+    static const int DEFAULT_HISTORY_MEMORY = 256;
+
+    // Time settings must stay unchanged before they are written
+    static const int SAVE_DELAY_MS = 500;
+
+    static SettingsModel * instance();
+
+    double getBrightness() const;
+    double getContrast() const;
+    QString getColorFilter() const;
+    int getAngle() const;
+    double getMinZoom() const;
+    int getMaxZoom() const;
+    bool isClickToDrag() const;
+    bool isLineDrawn() const;
+    int getLinePos() const;
+    int getLineThickness() const;
+    QColor getLineColor() const;
+    int getMaxFps() const;
+    int getHistoryMemory() const;
+    int getDeviceIndex() const;
+    QString getDeviceName() const;
+    QString getDeviceId() const;
+
+public slots:
+    void beginEditing();
+    void commitEditing();
+    void revertEditing();
+    void setBrightness(double brightness);
+    void setContrast(double contrast);
+    void setColorFilter(const QString & colorFilter);
+    void setAngle(int angle);
+    void setMinZoom(double minZoom);
+    void setMaxZoom(int maxZoom);
+    void setClickToDrag(bool clickToDrag);
+    void setLineDrawn(bool lineDrawn);
+    void setLinePos(int linePos);
+    void setLineThickness(int lineThickness);
+    void setLineColor(const QColor & lineColor);
+    void setMaxFps(int maxFps);
+    void setHistoryMemory(int historyMemory);
+    void setDeviceIndex(int deviceIndex);
+    void setDeviceName(const QString & deviceName);
+    void setDeviceId(const QString & deviceId);
+    void save();
+
+signals:
+    void brightnessChanged(double brightness);
+    void contrastChanged(double contrast);
+    void colorFilterChanged(const QString & colorFilter);
+    void angleChanged(int angle);
+    void minZoomChanged(double minZoom);
+    void maxZoomChanged(int maxZoom);
+    void clickToDragChanged(bool clickToDrag);
+    void lineDrawnChanged(bool lineDrawn);
+    void linePosChanged(int linePos);
+    void lineThicknessChanged(int lineThickness);
+    void lineColorChanged(const QColor & lineColor);
+    void maxFpsChanged(int maxFps);
+    void historyMemoryChanged(int historyMemory);
+    void deviceIndexChanged(int deviceIndex);
+    void deviceNameChanged(const QString & deviceName);
+    void deviceIdChanged(const QString & deviceId);
+
+private:
+    struct Values {
+        double brightness = DEFAULT_BRIGHTNESS;
+        double contrast = DEFAULT_CONTRAST;
+        QString colorFilter = DEFAULT_FILTER;
+        int angle = DEFAULT_ANGLE;
+        double minZoom = DEFAULT_MIN_ZOOM;
+        int maxZoom = DEFAULT_MAX_ZOOM;
+        bool clickToDrag = DEFAULT_CLICK_TO_DRAG;
+        bool lineDrawn = DEFAULT_IS_LINE_DRAWN;
+        int linePos = DEFAULT_LINE_POS;
+        int lineThickness = DEFAULT_LINE_THICKNESS;
+        QColor lineColor = DEFAULT_LINE_COLOR;
+        int maxFps = DEFAULT_MAX_FPS;
+        int historyMemory = DEFAULT_HISTORY_MEMORY;
+        // Index the webcam was last opened with, which is only correct until webcams are plugged in or out
+        int deviceIndex = DEFAULT_DEVICE;
+        QString deviceName;
+        // Stable identity of the webcam (see DeviceRegistry), empty until one is chosen
+        QString deviceId;
+    };
+
+    Values values;
+    // Values from before editing started, restored if editing is cancelled
+    Values committedValues;
+    bool editing = false;
+    QTimer saveTimer;
+
+    SettingsModel(QObject * parent = nullptr);
+    ~SettingsModel();
+
+    void load();
+    void scheduleSave();
+    void setValues(const Values & newValues);
+};
+
+#endif // SETTINGSMODEL_H
@@ -0,0 +1,275 @@
+#include "snapshotfile.h"
+
+const char SnapshotFile::MAGIC[8] = {'M', 'R', 'S', 'N', 'A', 'P', 'S', 'H'};
+
+SnapshotFile::SnapshotFile(const QString & path)
+    : file(path) {
+}
+
+/*
+ * Save a snapshot's pyramid, unmodified image, settings and view. The file is only replaced once it's
+ * completely written
+ */
+bool SnapshotFile::write(const QString & path, const TilePyramid & pyramid, const cv::Mat & source,
+                         const ImageSettings & settings, double zoom, QPointF center) {
+    TRACE_SCOPE("Write snapshot file");
+
+    if (pyramid.isEmpty() || pyramid.getLevelCount() > MAX_LEVELS || source.empty()) {
+        return false;
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.levelCount = quint32(pyramid.getLevelCount());
+    header.contrast = settings.contrast;
+    header.brightness = settings.brightness;
+    header.angle = settings.angle;
+    std::strncpy(header.filter, settings.filter.c_str(), sizeof(header.filter) - 1);
+    header.zoom = zoom;
+    header.centerX = center.x();
+    header.centerY = center.y();
+
+    // Levels & the unmodified image each start on a new page
+    QVector<LevelHeader> levels(pyramid.getLevelCount());
+    qint64 offset = alignOffset(qint64(sizeof(Header) + levels.count() * sizeof(LevelHeader)));
+    for (int i = 0; i < levels.count(); i++) {
+        const TilePyramid::Level & level = pyramid.getLevel(i);
+        const QImage & firstTile = level.tiles.first();
+        levels[i].width = level.size.width();
+        levels[i].height = level.size.height();
+        levels[i].format = qint32(firstTile.format());
+        levels[i].bitsPerPixel = firstTile.depth();
+        levels[i].offset = quint64(offset);
+        if (!isFormatValid(firstTile.format(), firstTile.depth())) {
+            return false;
+        }
+        offset = alignOffset(offset + level.tiles.count() * getTileBytesPerLine(firstTile.depth()) * TilePyramid::TILE_SIZE);
+    }
+    header.sourceWidth = source.cols;
+    header.sourceHeight = source.rows;
+    header.sourceType = source.type();
+    header.sourceOffset = quint64(offset);
+
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(levels.constData()), qint64(levels.count() * sizeof(LevelHeader)));
+
+    for (int i = 0; i < levels.count(); i++) {
+        writePadding(out, qint64(levels[i].offset));
+        qint64 bytesPerLine = getTileBytesPerLine(levels[i].bitsPerPixel);
+        QByteArray tileData(int(bytesPerLine * TilePyramid::TILE_SIZE), 0);
+        for (const QImage & tile : pyramid.getLevel(i).tiles) {
+            if (tile.format() != QImage::Format(levels[i].format)) {
+                out.cancelWriting();
+                return false;
+            }
+
+            // Tiles at the right & bottom edges are smaller, so they are padded
+            tileData.fill(0);
+            size_t rowBytes = size_t((qint64(tile.width()) * levels[i].bitsPerPixel + 7) / 8);
+            for (int y = 0; y < tile.height(); y++) {
+                std::memcpy(tileData.data() + y * bytesPerLine, tile.constScanLine(y), rowBytes);
+            }
+            out.write(tileData);
+        }
+    }
+
+    writePadding(out, qint64(header.sourceOffset));
+    for (int y = 0; y < source.rows; y++) {
+        out.write(reinterpret_cast<const char *>(source.ptr(y)), qint64(source.cols * source.elemSize()));
+    }
+
+    // Errors while writing are reported here, and leave the old file in place
+    return out.commit();
+}
+
+/*
+ * Map a snapshot file into memory (nothing is read yet). Returns null if it can't be opened or isn't valid
+ */
+QSharedPointer<SnapshotFile> SnapshotFile::open(const QString & path) {
+    TRACE_SCOPE("Open snapshot file");
+
+    QSharedPointer<SnapshotFile> snapshotFile(new SnapshotFile(path));
+
+    // Opened for writing too, so that the view can be updated in place
+    if (!snapshotFile->file.open(QFile::ReadWrite)) {
+        return QSharedPointer<SnapshotFile>();
+    }
+    snapshotFile->size = snapshotFile->file.size();
+    snapshotFile->data = snapshotFile->file.map(0, snapshotFile->size);
+    if (snapshotFile->data == nullptr || !snapshotFile->isValid()) {
+        return QSharedPointer<SnapshotFile>();
+    }
+
+    return snapshotFile;
+}
+
+/*
+ * Pyramid whose tiles are drawn straight from the mapped file. Each tile keeps the file mapped while it's in use
+ */
+QSharedPointer<TilePyramid> SnapshotFile::getPyramid() {
+    const Header * header = getHeader();
+
+    QSharedPointer<TilePyramid> pyramid(new TilePyramid());
+    for (int i = 0; i < int(header->levelCount); i++) {
+        const LevelHeader * levelHeader = getLevelHeader(i);
+        QImage::Format format = QImage::Format(levelHeader->format);
+        int bytesPerLine = int(getTileBytesPerLine(levelHeader->bitsPerPixel));
+        qint64 tileBytes = qint64(TilePyramid::TILE_SIZE) * bytesPerLine;
+        QSize levelSize(levelHeader->width, levelHeader->height);
+        int columns = (levelSize.width() + TilePyramid::TILE_SIZE - 1) / TilePyramid::TILE_SIZE;
+        int rows = (levelSize.height() + TilePyramid::TILE_SIZE - 1) / TilePyramid::TILE_SIZE;
+
+        QVector<QImage> tiles;
+        tiles.reserve(columns * rows);
+        for (int row = 0; row < rows; row++) {
+            for (int column = 0; column < columns; column++) {
+                QRect tileRect = QRect(column * TilePyramid::TILE_SIZE, row * TilePyramid::TILE_SIZE,
+                                       TilePyramid::TILE_SIZE, TilePyramid::TILE_SIZE) & QRect(QPoint(0, 0), levelSize);
+                // Writable data, so that packed tiles can be given their colour table without being copied
+                // (tiles are never drawn on)
+                uchar * tileData = data + levelHeader->offset + (row * columns + column) * tileBytes;
+                QImage tile(tileData, tileRect.width(), tileRect.height(), bytesPerLine, format,
+                            releaseTile, new QSharedPointer<SnapshotFile>(sharedFromThis()));
+                if (format == QImage::Format_Mono) {
+                    tile.setColorTable(QVector<QRgb>{qRgb(0, 0, 0), qRgb(255, 255, 255)});
+                }
+                tiles.append(tile);
+            }
+        }
+        pyramid->addLevel(levelSize, tiles);
+    }
+
+    return pyramid;
+}
+
+/*
+ * Copy of the unmodified snapshot (this reads the whole of it from the file)
+ */
+cv::Mat SnapshotFile::readSource() const {
+    TRACE_SCOPE("Read snapshot source");
+
+    const Header * header = getHeader();
+    return cv::Mat(header->sourceHeight, header->sourceWidth, header->sourceType,
+                   data + header->sourceOffset).clone();
+}
+
+/*
+ * Settings the pyramid was processed with
+ */
+ImageSettings SnapshotFile::getSettings() const {
+    const Header * header = getHeader();
+
+    ImageSettings settings;
+    settings.contrast = header->contrast;
+    settings.brightness = header->brightness;
+    settings.angle = header->angle;
+    settings.filter = std::string(header->filter, qstrnlen(header->filter, sizeof(header->filter)));
+    return settings;
+}
+
+double SnapshotFile::getZoom() const {
+    return getHeader()->zoom;
+}
+
+/*
+ * Point of the snapshot at the centre of the view
+ */
+QPointF SnapshotFile::getCenter() const {
+    return QPointF(getHeader()->centerX, getHeader()->centerY);
+}
+
+/*
+ * Update the view saved in the file, in place
+ */
+void SnapshotFile::setView(double zoom, QPointF center) {
+    Header * header = reinterpret_cast<Header *>(data);
+    header->zoom = zoom;
+    header->centerX = center.x();
+    header->centerY = center.y();
+}
+
+const SnapshotFile::Header * SnapshotFile::getHeader() const {
+    return reinterpret_cast<const Header *>(data);
+}
+
+const SnapshotFile::LevelHeader * SnapshotFile::getLevelHeader(int level) const {
+    return reinterpret_cast<const LevelHeader *>(data + sizeof(Header)) + level;
+}
+
+/*
+ * Whether the mapped file is a snapshot file, and every part of it is within the file
+ */
+bool SnapshotFile::isValid() const {
+    if (size < qint64(sizeof(Header))) {
+        return false;
+    }
+
+    const Header * header = getHeader();
+    if (std::memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 || header->version != VERSION
+            || header->levelCount < 1 || header->levelCount > quint32(MAX_LEVELS)
+            || size < qint64(sizeof(Header) + header->levelCount * sizeof(LevelHeader))) {
+        return false;
+    }
+
+    for (int i = 0; i < int(header->levelCount); i++) {
+        const LevelHeader * level = getLevelHeader(i);
+        if (level->width <= 0 || level->height <= 0 || level->offset % PAGE_ALIGNMENT != 0
+                || !isFormatValid(QImage::Format(level->format), level->bitsPerPixel)) {
+            return false;
+        }
+        qint64 tileBytes = getTileBytesPerLine(level->bitsPerPixel) * TilePyramid::TILE_SIZE;
+        qint64 columns = (level->width + TilePyramid::TILE_SIZE - 1) / TilePyramid::TILE_SIZE;
+        qint64 rows = (level->height + TilePyramid::TILE_SIZE - 1) / TilePyramid::TILE_SIZE;
+        if (qint64(level->offset) + columns * rows * tileBytes > size) {
+            return false;
+        }
+    }
+
+    qint64 sourceBytes = qint64(header->sourceWidth) * header->sourceHeight * CV_ELEM_SIZE(header->sourceType);
+    return header->sourceWidth > 0 && header->sourceHeight > 0
+            && qint64(header->sourceOffset) + sourceBytes <= size;
+}
+
+qint64 SnapshotFile::alignOffset(qint64 offset) {
+    return (offset + PAGE_ALIGNMENT - 1) / PAGE_ALIGNMENT * PAGE_ALIGNMENT;
+}
+
+/*
+ * Bytes in each row of a padded tile
+ */
+qint64 SnapshotFile::getTileBytesPerLine(int bitsPerPixel) {
+    return (qint64(TilePyramid::TILE_SIZE) * bitsPerPixel + 7) / 8;
+}
+
+/*
+ * Only the formats that pyramids are built in
+ */
+bool SnapshotFile::isFormatValid(QImage::Format format, int bitsPerPixel) {
+    return (format == QImage::Format_RGB32 && bitsPerPixel == 32)
+            || (format == QImage::Format_RGB888 && bitsPerPixel == 24)
+            || (format == QImage::Format_Grayscale8 && bitsPerPixel == 8)
+            || (format == QImage::Format_Mono && bitsPerPixel == 1);
+}
+
+/*
+ * Write zeros up to the given offset
+ */
+void SnapshotFile::writePadding(QSaveFile & out, qint64 offset) {
+    qint64 padding = offset - out.pos();
+    if (padding > 0) {
+        out.write(QByteArray(int(padding), 0));
+    }
+}
+
+/*
+ * Cleanup of a tile drawn from the file (see getPyramid())
+ */
+void SnapshotFile::releaseTile(void * file) {
+    delete static_cast<QSharedPointer<SnapshotFile> *>(file);
+}
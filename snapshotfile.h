@@ -0,0 +1,97 @@
+#ifndef SNAPSHOTFILE_H
+#define SNAPSHOTFILE_H
+
+// Implementation classes
+#include <cstring>
+
+#include <QByteArray>
+#include <QEnableSharedFromThis>
+#include <QFile>
+#include <QImage>
+#include <QPointF>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <opencv2/core.hpp>
+
+#include "imagesettings.h"
+#include "tilepyramid.h"
+#include "tracer.h"
+
+/*
+ * Snapshot saved uncompressed, so that it can be shown again straight from a memory-mapped file: every level
+ * of its tile pyramid (each tile padded to TILE_SIZE, so tiles can be drawn in place), the unmodified snapshot
+ * (to process it again), the settings it was processed with and the view's zoom & centre.
+ * Only the pages of the tiles that are drawn are ever read. Files are only meant to be read back on the
+ * machine that wrote them (values are stored in its byte order)
+ */
+class SnapshotFile : public QEnableSharedFromThis<SnapshotFile> {
+
+private:
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 levelCount;
+        // Settings the pyramid was processed with
+        double contrast;
+        double brightness;
+        qint32 angle;
+        char filter[20];
+        // View of the snapshot
+        double zoom;
+        double centerX;
+        double centerY;
+        // Format of the unmodified snapshot (an OpenCV type)
+        qint32 sourceWidth;
+        qint32 sourceHeight;
+        qint32 sourceType;
+        qint32 reserved;
+        quint64 sourceOffset;
+    };
+
+    struct LevelHeader {
+        qint32 width;
+        qint32 height;
+        // Format of every tile in the level (black & white snapshots are packed in their first level only)
+        qint32 format;
+        qint32 bitsPerPixel;
+        quint64 offset;
+    };
+
+    QFile file;
+    uchar * data = nullptr;
+    qint64 size = 0;
+
+    SnapshotFile(const QString & path);
+
+    const Header * getHeader() const;
+    const LevelHeader * getLevelHeader(int level) const;
+    bool isValid() const;
+    static qint64 alignOffset(qint64 offset);
+    static qint64 getTileBytesPerLine(int bitsPerPixel);
+    static bool isFormatValid(QImage::Format format, int bitsPerPixel);
+    static void writePadding(QSaveFile & out, qint64 offset);
+    static void releaseTile(void * file);
+
+public:
+    static const char MAGIC[8];
+    static const quint32 VERSION = 2;
+    // Data is aligned to pages, so that a tile never shares a page with the header
+    static const qint64 PAGE_ALIGNMENT = 4096;
+    static const int MAX_LEVELS = 32;
+
+    static bool write(const QString & path, const TilePyramid & pyramid, const cv::Mat & source,
+                      const ImageSettings & settings, double zoom, QPointF center);
+    static QSharedPointer<SnapshotFile> open(const QString & path);
+
+    QSharedPointer<TilePyramid> getPyramid();
+    cv::Mat readSource() const;
+    ImageSettings getSettings() const;
+    double getZoom() const;
+    QPointF getCenter() const;
+    void setView(double zoom, QPointF center);
+};
+
+#endif // SNAPSHOTFILE_H
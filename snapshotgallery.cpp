@@ -0,0 +1,61 @@
+#include "snapshotgallery.h"
+
+SnapshotGallery::SnapshotGallery(SnapshotHistory * history, QWidget * parent)
+    : QListWidget(parent) {
+    this->history = history;
+
+    // Single row of thumbnails, scrolled sideways
+    setViewMode(QListView::IconMode);
+    setFlow(QListView::LeftToRight);
+    setWrapping(false);
+    setMovement(QListView::Static);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setUniformItemSizes(true);
+    setIconSize(QSize(SnapshotHistory::THUMBNAIL_SIZE, SnapshotHistory::THUMBNAIL_SIZE));
+    setGridSize(iconSize() + QSize(ITEM_MARGIN, ITEM_MARGIN));
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setFixedHeight(gridSize().height() + horizontalScrollBar()->sizeHint().height() + 2 * frameWidth());
+
+    // Hidden until there is a snapshot to go back to
+    setVisible(false);
+
+    connect(history, SIGNAL (thumbnailReady(int)), this, SLOT (addSnapshot(int)));
+    connect(history, SIGNAL (snapshotRemoved(int)), this, SLOT (removeSnapshot(int)));
+    connect(this, SIGNAL (itemClicked(QListWidgetItem *)), this, SLOT (selectItem(QListWidgetItem *)));
+}
+
+/*
+ * Show the thumbnail of a snapshot that was just taken
+ */
+void SnapshotGallery::addSnapshot(int id) {
+    QListWidgetItem * item = new QListWidgetItem(QIcon(QPixmap::fromImage(history->getThumbnail(id))), QString());
+    item->setData(Qt::UserRole, id);
+    item->setToolTip("Taken at " + history->getTakenAt(id).toString("hh:mm:ss"));
+    addItem(item);
+    scrollToItem(item);
+
+    setVisible(true);
+}
+
+void SnapshotGallery::removeSnapshot(int id) {
+    delete findItem(id);
+
+    setVisible(count() > 0);
+}
+
+void SnapshotGallery::selectItem(QListWidgetItem * item) {
+    emit snapshotSelected(item->data(Qt::UserRole).toInt());
+}
+
+/*
+ * Item showing the snapshot with the given id (nullptr if there isn't one)
+ */
+QListWidgetItem * SnapshotGallery::findItem(int id) {
+    for (int i = 0; i < count(); i++) {
+        if (item(i)->data(Qt::UserRole).toInt() == id) {
+            return item(i);
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,41 @@
+#ifndef SNAPSHOTGALLERY_H
+#define SNAPSHOTGALLERY_H
+
+// Parent class
+#include <QListWidget>
+
+// Implementation classes
+#include <QIcon>
+#include <QListWidgetItem>
+#include <QPixmap>
+#include <QScrollBar>
+
+#include "snapshothistory.h"
+
+/*
+ * Strip of thumbnails of the snapshots in the history, newest last. Clicking one shows that snapshot again
+ */
+class SnapshotGallery : public QListWidget {
+    Q_OBJECT
+
+private:
+    SnapshotHistory * history;
+
+    QListWidgetItem * findItem(int id);
+
+private slots:
+    void addSnapshot(int id);
+    void removeSnapshot(int id);
+    void selectItem(QListWidgetItem * item);
+
+public:
+    // Space around each thumbnail
+    static const int ITEM_MARGIN = 8;
+
+    SnapshotGallery(SnapshotHistory * history, QWidget * parent = nullptr);
+
+signals:
+    void snapshotSelected(int id);
+};
+
+#endif // SNAPSHOTGALLERY_H
@@ -0,0 +1,300 @@
+#include "snapshothistory.h"
+
+SnapshotHistory::SnapshotHistory(QObject * parent)
+    : QThread(parent) {
+}
+
+/*
+ * Keep a new snapshot (which mustn't be modified afterwards), forgetting the oldest one if there are too many.
+ * Returns its id, which thumbnailReady() is emitted with once it's compressed
+ */
+int SnapshotHistory::add(const cv::Mat & snapshot) {
+    if (snapshot.empty()) {
+        return -1;
+    }
+
+    QList<int> removed;
+    mutex.lock();
+    int id = nextId++;
+    Entry & entry = entries[id];
+    entry.pending = snapshot;
+    entry.takenAt = QDateTime::currentDateTime();
+    compressQueue.append(id);
+
+    while (entries.size() > MAX_SNAPSHOTS) {
+        int oldest = entries.firstKey();
+        memoryUsed -= entries[oldest].blob.size();
+        entries.remove(oldest);
+        lru.removeOne(oldest);
+        compressQueue.removeOne(oldest);
+        removed.append(oldest);
+    }
+    requested.wakeOne();
+    mutex.unlock();
+
+    for (int oldest : removed) {
+        QFile::remove(storePath(oldest));
+        emit snapshotRemoved(oldest);
+    }
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+
+    return id;
+}
+
+/*
+ * Request a snapshot to be decompressed (snapshotLoaded() is emitted once it's ready), replacing any earlier request
+ */
+void SnapshotHistory::load(int id) {
+    mutex.lock();
+    loadRequest = id;
+    requested.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+}
+
+/*
+ * Get the last snapshot that was decompressed (false if none was since the last call)
+ */
+bool SnapshotHistory::takeLoaded(int & id, cv::Mat & snapshot) {
+    mutex.lock();
+    bool isLoaded = (loadedId >= 0);
+    if (isLoaded) {
+        id = loadedId;
+        snapshot = loadedSnapshot;
+        loadedId = -1;
+        loadedSnapshot.release();
+    }
+    mutex.unlock();
+
+    return isLoaded;
+}
+
+QImage SnapshotHistory::getThumbnail(int id) {
+    mutex.lock();
+    QImage thumbnail = entries.value(id).thumbnail;
+    mutex.unlock();
+
+    return thumbnail;
+}
+
+QDateTime SnapshotHistory::getTakenAt(int id) {
+    mutex.lock();
+    QDateTime takenAt = entries.value(id).takenAt;
+    mutex.unlock();
+
+    return takenAt;
+}
+
+/*
+ * Limit the memory used by compressed snapshots. Snapshots beyond it are moved to disk in the background
+ */
+void SnapshotHistory::setMemoryBudget(qint64 bytes) {
+    mutex.lock();
+    memoryBudget = qMax(qint64(0), bytes);
+    isBudgetChanged = true;
+    requested.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+}
+
+qint64 SnapshotHistory::getMemoryUsed() {
+    mutex.lock();
+    qint64 used = memoryUsed;
+    mutex.unlock();
+
+    return used;
+}
+
+/*
+ * Wait for requests, then decompress the snapshot to show before compressing any new ones
+ */
+void SnapshotHistory::run() {
+    forever {
+        mutex.lock();
+        while (loadRequest < 0 && compressQueue.isEmpty() && !isBudgetChanged && !stopping) {
+            requested.wait(&mutex);
+        }
+        if (stopping) {
+            mutex.unlock();
+            break;
+        }
+
+        if (loadRequest >= 0) {
+            int id = loadRequest;
+            loadRequest = -1;
+            mutex.unlock();
+            decompress(id);
+        }
+        else if (!compressQueue.isEmpty()) {
+            int id = compressQueue.takeFirst();
+            cv::Mat snapshot = entries.value(id).pending;
+            mutex.unlock();
+            compress(id, snapshot);
+        }
+        else {
+            isBudgetChanged = false;
+            mutex.unlock();
+            evict();
+        }
+    }
+}
+
+QString SnapshotHistory::storePath(int id) const {
+    return storeDir.filePath(QString("%1.png").arg(id));
+}
+
+/*
+ * Make the thumbnail and compress the snapshot, keeping it in memory
+ */
+void SnapshotHistory::compress(int id, const cv::Mat & snapshot) {
+    TRACE_SCOPE("Compress snapshot");
+
+    double scale = qMin(1.0, double(THUMBNAIL_SIZE) / qMax(snapshot.cols, snapshot.rows));
+    cv::Mat small;
+    cv::resize(snapshot, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    QImage thumbnail = WebcamPlayer::convertMatToQImage(small);
+
+    std::vector<uchar> buffer;
+    bool isEncoded = cv::imencode(".png", snapshot, buffer, {cv::IMWRITE_PNG_COMPRESSION, PNG_COMPRESSION});
+
+    mutex.lock();
+    auto found = entries.find(id);
+    if (found == entries.end()) {
+        // Forgotten while it was being compressed
+        mutex.unlock();
+        return;
+    }
+    found->thumbnail = thumbnail;
+    // Snapshots that can't be compressed are kept as they are
+    if (isEncoded) {
+        found->blob = QByteArray(reinterpret_cast<const char *>(buffer.data()), int(buffer.size()));
+        found->pending.release();
+        memoryUsed += found->blob.size();
+        lru.prepend(id);
+    }
+    mutex.unlock();
+
+    emit thumbnailReady(id);
+    evict();
+}
+
+/*
+ * Decompress a snapshot (reading it back from disk if needed) and hand it over, unless a newer one was requested
+ */
+void SnapshotHistory::decompress(int id) {
+    TRACE_SCOPE("Decompress snapshot");
+
+    mutex.lock();
+    cv::Mat snapshot;
+    QByteArray blob;
+    bool isStored = false;
+    auto found = entries.find(id);
+    if (found != entries.end()) {
+        snapshot = found->pending;
+        blob = found->blob;
+        isStored = found->isStored;
+        if (!blob.isEmpty()) {
+            lru.removeOne(id);
+            lru.prepend(id);
+        }
+    }
+    mutex.unlock();
+
+    // Snapshot read back from disk becomes the most recently used one in memory
+    if (snapshot.empty() && blob.isEmpty() && isStored) {
+        QFile file(storePath(id));
+        if (file.open(QFile::ReadOnly)) {
+            blob = file.readAll();
+        }
+
+        mutex.lock();
+        found = entries.find(id);
+        if (!blob.isEmpty() && found != entries.end() && found->blob.isEmpty()) {
+            found->blob = blob;
+            memoryUsed += blob.size();
+            lru.prepend(id);
+        }
+        mutex.unlock();
+        evict();
+    }
+
+    if (snapshot.empty() && !blob.isEmpty()) {
+        cv::Mat data(1, blob.size(), CV_8UC1, const_cast<char *>(blob.constData()));
+        snapshot = cv::imdecode(data, cv::IMREAD_UNCHANGED);
+    }
+
+    mutex.lock();
+    bool isStale = (loadRequest >= 0);
+    if (!isStale) {
+        loadedId = id;
+        loadedSnapshot = snapshot;
+    }
+    mutex.unlock();
+
+    if (!isStale) {
+        emit snapshotLoaded();
+    }
+}
+
+/*
+ * Write least recently used snapshots to disk until the memory budget is respected
+ */
+void SnapshotHistory::evict() {
+    forever {
+        mutex.lock();
+        if (memoryUsed <= memoryBudget || lru.isEmpty()) {
+            mutex.unlock();
+            return;
+        }
+        int id = lru.last();
+        QByteArray blob = entries[id].blob;
+        bool isStored = entries[id].isStored;
+        mutex.unlock();
+
+        // Snapshots never change, so one that was stored before only needs to leave memory
+        if (!isStored) {
+            QFile file(storePath(id));
+            isStored = storeDir.isValid() && file.open(QFile::WriteOnly) && file.write(blob) == blob.size();
+        }
+
+        mutex.lock();
+        if (!isStored) {
+            // Snapshots that can't be stored are kept in memory rather than lost
+            mutex.unlock();
+            return;
+        }
+        auto found = entries.find(id);
+        bool isForgotten = (found == entries.end());
+        if (!isForgotten && !found->blob.isEmpty()) {
+            memoryUsed -= found->blob.size();
+            found->blob.clear();
+            found->isStored = true;
+        }
+        lru.removeOne(id);
+        mutex.unlock();
+
+        // Snapshot was forgotten while it was being written
+        if (isForgotten) {
+            QFile::remove(storePath(id));
+        }
+    }
+}
+
+SnapshotHistory::~SnapshotHistory() {
+    mutex.lock();
+    stopping = true;
+    requested.wakeAll();
+    mutex.unlock();
+
+    // Stop running thread
+    wait();
+}
@@ -0,0 +1,101 @@
+#ifndef SNAPSHOTHISTORY_H
+#define SNAPSHOTHISTORY_H
+
+// Parent class
+#include <QThread>
+
+// Implementation classes
+#include <vector>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QTemporaryDir>
+#include <QWaitCondition>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "tracer.h"
+#include "webcamplayer.h"
+
+/*
+ * Keeps every snapshot taken in the session, so that earlier pages can be shown again. Snapshots are
+ * kept unmodified (to be processed with the current settings when shown) and losslessly compressed as PNG
+ * in the background, where their thumbnails are also made. Compressed snapshots stay in memory up to a
+ * budget; beyond it the least recently used ones are written to a temporary directory and read back when needed
+ */
+class SnapshotHistory : public QThread {
+    Q_OBJECT
+
+private:
+    struct Entry {
+        // Snapshot waiting to be compressed
+        cv::Mat pending;
+        // Compressed snapshot, empty once it's only on disk
+        QByteArray blob;
+        bool isStored = false;
+        QImage thumbnail;
+        QDateTime takenAt;
+    };
+
+    QMutex mutex;
+    QWaitCondition requested;
+    QMap<int, Entry> entries;
+    // Ids of compressed snapshots in memory, from most to least recently used
+    QList<int> lru;
+    // Ids waiting to be compressed, oldest first
+    QList<int> compressQueue;
+    int nextId = 0;
+    qint64 memoryUsed = 0;
+    qint64 memoryBudget = DEFAULT_MEMORY_BUDGET;
+    bool isBudgetChanged = false;
+    bool stopping = false;
+    QTemporaryDir storeDir;
+
+    // Latest snapshot requested to be shown, and the result once it's decompressed
+    int loadRequest = -1;
+    int loadedId = -1;
+    cv::Mat loadedSnapshot;
+
+    QString storePath(int id) const;
+    void compress(int id, const cv::Mat & snapshot);
+    void decompress(int id);
+    void evict();
+
+protected:
+    void run();
+
+public:
+    static const qint64 DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+    // Oldest snapshots are forgotten beyond this many (so the temporary directory doesn't grow forever)
+    static const int MAX_SNAPSHOTS = 500;
+    // Longest side of a thumbnail
+    static const int THUMBNAIL_SIZE = 160;
+    // Fastest zlib level, since decompressing quickly matters more than the last few percent of size
+    static const int PNG_COMPRESSION = 1;
+
+    SnapshotHistory(QObject * parent = nullptr);
+    ~SnapshotHistory();
+
+    int add(const cv::Mat & snapshot);
+    void load(int id);
+    bool takeLoaded(int & id, cv::Mat & snapshot);
+    QImage getThumbnail(int id);
+    QDateTime getTakenAt(int id);
+    void setMemoryBudget(qint64 bytes);
+    qint64 getMemoryUsed();
+
+signals:
+    void thumbnailReady(int id);
+    void snapshotRemoved(int id);
+    void snapshotLoaded();
+};
+
+#endif // SNAPSHOTHISTORY_H
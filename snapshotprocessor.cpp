@@ -0,0 +1,121 @@
+#include "snapshotprocessor.h"
+
+SnapshotProcessor::SnapshotProcessor(QObject * parent)
+    : QThread(parent) {
+}
+
+/*
+ * Replace the unmodified snapshot image that is processed
+ */
+void SnapshotProcessor::setSnapshot(const cv::Mat & snapshot) {
+    mutex.lock();
+    pendingSnapshot = snapshot;
+    isSnapshotChanged = true;
+    mutex.unlock();
+}
+
+/*
+ * Request the snapshot to be processed with the given settings, replacing any earlier request.
+ * Returns the id that the results will be sent with
+ */
+int SnapshotProcessor::process(const ImageSettings & settings) {
+    mutex.lock();
+    pendingSettings = settings;
+    hasPending = true;
+    int id = ++requestId;
+    requested.wakeOne();
+    mutex.unlock();
+
+    if (!isRunning()) {
+        start(LowPriority);
+    }
+
+    return id;
+}
+
+/*
+ * Whether a newer request was made since the one with this id
+ */
+bool SnapshotProcessor::isStale(int id) {
+    mutex.lock();
+    bool isStale = (id != requestId) || stopping;
+    mutex.unlock();
+
+    return isStale;
+}
+
+/*
+ * Wait for requests, then process a preview and the full image of the latest one
+ */
+void SnapshotProcessor::run() {
+    forever {
+        mutex.lock();
+        while (!hasPending && !stopping) {
+            requested.wait(&mutex);
+        }
+        if (stopping) {
+            mutex.unlock();
+            break;
+        }
+        bool isNewSnapshot = isSnapshotChanged;
+        cv::Mat snapshot = pendingSnapshot;
+        pendingSnapshot.release();
+        isSnapshotChanged = false;
+        ImageSettings settings = pendingSettings;
+        int id = requestId;
+        hasPending = false;
+        mutex.unlock();
+
+        if (isNewSnapshot) {
+            setPipelineSource(snapshot);
+        }
+        if (!pipeline.hasSource()) {
+            continue;
+        }
+
+        auto isCancelled = [this, id]() { return isStale(id); };
+
+        // Quick preview to show while the full image is processed
+        if (previewPipeline.hasSource()) {
+            cv::Mat preview = previewPipeline.process(settings, isCancelled);
+            if (preview.empty() || isStale(id)) {
+                continue;
+            }
+            emit previewProcessed(WebcamPlayer::convertMatToQImage(preview, settings.isBinary()), previewScale, id);
+        }
+
+        cv::Mat processed = pipeline.process(settings, isCancelled);
+        if (processed.empty() || isStale(id)) {
+            continue;
+        }
+        emit snapshotProcessed(WebcamPlayer::convertMatToQImage(processed, settings.isBinary()), id);
+    }
+}
+
+/*
+ * Start caching stages for a new snapshot, and for a downscaled copy of it if it is larger than a preview
+ */
+void SnapshotProcessor::setPipelineSource(const cv::Mat & snapshot) {
+    pipeline.setSource(snapshot);
+
+    previewScale = snapshot.empty() ? 1 : double(PREVIEW_SIZE) / qMax(snapshot.cols, snapshot.rows);
+    if (previewScale < 1) {
+        cv::Mat preview;
+        cv::resize(snapshot, preview, cv::Size(), previewScale, previewScale, cv::INTER_AREA);
+        previewPipeline.setSource(preview);
+    }
+    else {
+        previewScale = 1;
+        previewPipeline.setSource(cv::Mat());
+    }
+}
+
+SnapshotProcessor::~SnapshotProcessor() {
+    mutex.lock();
+    stopping = true;
+    requested.wakeAll();
+    mutex.unlock();
+
+    // Stop running thread
+    wait();
+}
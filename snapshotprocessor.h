@@ -0,0 +1,65 @@
+#ifndef SNAPSHOTPROCESSOR_H
+#define SNAPSHOTPROCESSOR_H
+
+// Parent class
+#include <QThread>
+
+// Implementation classes
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "imagepipeline.h"
+#include "imagesettings.h"
+#include "webcamplayer.h"
+
+/*
+ * Processes the snapshot image in the background. Requests are coalesced so that only the latest one
+ * is processed, and a request that became stale is abandoned between stages. A downscaled preview
+ * is sent first, followed by the full resolution result. The output of each stage is cached, so only
+ * the stages affected by a changed setting are processed again
+ */
+class SnapshotProcessor : public QThread {
+    Q_OBJECT
+
+private:
+    QMutex mutex;
+    QWaitCondition requested;
+    cv::Mat pendingSnapshot;
+    bool isSnapshotChanged = false;
+    ImageSettings pendingSettings;
+    bool hasPending = false;
+    bool stopping = false;
+    // Id of the latest request
+    int requestId = 0;
+
+    // Only used by the processing thread
+    ImagePipeline pipeline;
+    ImagePipeline previewPipeline;
+    double previewScale = 1;
+
+    bool isStale(int id);
+    void setPipelineSource(const cv::Mat & snapshot);
+
+protected:
+    void run();
+
+public:
+    // Longest side of the preview image, small enough to process on every slider tick
+    static const int PREVIEW_SIZE = 1280;
+
+    SnapshotProcessor(QObject * parent = nullptr);
+    ~SnapshotProcessor();
+
+    void setSnapshot(const cv::Mat & snapshot);
+    int process(const ImageSettings & settings);
+
+signals:
+    void previewProcessed(const QImage & preview, double previewScale, int requestId);
+    void snapshotProcessed(const QImage & image, int requestId);
+};
+
+#endif // SNAPSHOTPROCESSOR_H
@@ -0,0 +1,48 @@
+#include "statsitem.h"
+
+StatsItem::StatsItem(QGraphicsItem * parent)
+    : OverlayItem(parent) {
+    // Fixed width font keeps columns aligned
+    font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    font.setPointSize(12);
+
+    setViewportPos(QPointF(MARGIN, MARGIN));
+}
+
+void StatsItem::setLines(const QStringList & lines) {
+    if (lines == this->lines) {
+        return;
+    }
+
+    prepareGeometryChange();
+    this->lines = lines;
+    update();
+}
+
+QRectF StatsItem::boundingRect() const {
+    QFontMetricsF metrics(font);
+    double width = 0;
+    for (const QString & line : lines) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+        width = qMax(width, metrics.horizontalAdvance(line));
+#else
+        width = qMax(width, metrics.width(line));
+#endif
+    }
+
+    return QRectF(0, 0, width + 2 * MARGIN, lines.count() * metrics.lineSpacing() + 2 * MARGIN);
+}
+
+void StatsItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget) {
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    painter->fillRect(boundingRect(), QColor(0, 0, 0, 180));
+
+    QFontMetricsF metrics(font);
+    painter->setFont(font);
+    painter->setPen(Qt::white);
+    for (int i = 0; i < lines.count(); i++) {
+        painter->drawText(QPointF(MARGIN, MARGIN + i * metrics.lineSpacing() + metrics.ascent()), lines[i]);
+    }
+}
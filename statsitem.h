@@ -0,0 +1,38 @@
+#ifndef STATSITEM_H
+#define STATSITEM_H
+
+// Parent class
+#include "overlayitem.h"
+
+// Implementation classes
+#include <QColor>
+#include <QFont>
+#include <QFontDatabase>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QString>
+#include <QStringList>
+#include <QStyleOptionGraphicsItem>
+
+/*
+ * Lines of statistics drawn in the top-left corner of the viewport, over a dark background so they stay
+ * readable over any image
+ */
+class StatsItem : public OverlayItem {
+
+private:
+    QStringList lines;
+    QFont font;
+
+public:
+    // Space between the text and the edges of its background
+    static const int MARGIN = 8;
+
+    StatsItem(QGraphicsItem * parent = nullptr);
+
+    void setLines(const QStringList & lines);
+    QRectF boundingRect() const;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr);
+};
+
+#endif // STATSITEM_H
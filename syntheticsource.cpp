@@ -0,0 +1,92 @@
+#include "syntheticsource.h"
+
+SyntheticSource::SyntheticSource(cv::Size size, double fps, unsigned int seed) {
+    this->size = size;
+    this->fps = fps;
+    this->seed = seed;
+}
+
+bool SyntheticSource::open() {
+    if (size.width <= 0 || size.height <= 0) {
+        return false;
+    }
+
+    drawPage();
+    frameIndex = 0;
+
+    return true;
+}
+
+bool SyntheticSource::isOpened() const {
+    return !page.empty();
+}
+
+/*
+ * Copy the part of the page in view (wrapping around at the bottom)
+ */
+bool SyntheticSource::read(cv::Mat & frame) {
+    if (page.empty()) {
+        return false;
+    }
+
+    pace(fps);
+
+    int step = std::max(1, SCROLL_STEP * size.height / 1080);
+    int top = (frameIndex * step) % page.rows;
+    frameIndex++;
+
+    frame.create(size, page.type());
+    int firstRows = std::min(size.height, page.rows - top);
+    page.rowRange(top, top + firstRows).copyTo(frame.rowRange(0, firstRows));
+    if (firstRows < size.height) {
+        page.rowRange(0, size.height - firstRows).copyTo(frame.rowRange(firstRows, size.height));
+    }
+
+    return true;
+}
+
+void SyntheticSource::release() {
+    page.release();
+}
+
+double SyntheticSource::getFps() const {
+    return fps;
+}
+
+QString SyntheticSource::getName() const {
+    return QString("synthetic %1x%2@%3").arg(size.width).arg(size.height).arg(fps);
+}
+
+/*
+ * Draw lines of random words, dark grey on off-white paper, sized to the frame height
+ */
+void SyntheticSource::drawPage() {
+    page = cv::Mat(size.height * PAGE_SCREENS, size.width, CV_8UC3, cv::Scalar(235, 240, 242));
+
+    cv::RNG rng(seed);
+    double fontScale = size.height / 720.0;
+    int thickness = std::max(1, cvRound(2 * fontScale));
+    int lineHeight = cvRound(48 * fontScale);
+    int margin = size.width / 16;
+
+    for (int y = margin + lineHeight; y < page.rows - lineHeight; y += lineHeight) {
+        int x = margin;
+        forever {
+            std::string word;
+            int letters = rng.uniform(2, 10);
+            for (int i = 0; i < letters; i++) {
+                word += char('a' + rng.uniform(0, 26));
+            }
+
+            int baseline = 0;
+            cv::Size wordSize = cv::getTextSize(word, cv::FONT_HERSHEY_SIMPLEX, fontScale, thickness, &baseline);
+            if (x + wordSize.width > size.width - margin) {
+                break;
+            }
+
+            cv::putText(page, word, cv::Point(x, y), cv::FONT_HERSHEY_SIMPLEX, fontScale,
+                        cv::Scalar(40, 40, 40), thickness, cv::LINE_AA);
+            x += wordSize.width + cvRound(20 * fontScale);
+        }
+    }
+}
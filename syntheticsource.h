@@ -0,0 +1,45 @@
+#ifndef SYNTHETICSOURCE_H
+#define SYNTHETICSOURCE_H
+
+// Parent class
+#include "framesource.h"
+
+// Implementation classes
+#include <algorithm>
+#include <string>
+
+#include <opencv2/imgproc.hpp>
+
+/*
+ * Generated page of text that slowly scrolls past, at a chosen resolution and frame rate. The same seed
+ * always gives the same frames, so runs can be compared without a webcam
+ */
+class SyntheticSource : public FrameSource {
+
+private:
+    cv::Size size;
+    double fps;
+    unsigned int seed;
+    cv::Mat page;
+    int frameIndex = 0;
+
+    void drawPage();
+
+public:
+    static constexpr double DEFAULT_FPS = 30;
+    // Page height as a multiple of the frame height (the page scrolls and wraps around)
+    static const int PAGE_SCREENS = 3;
+    // Pixels the page scrolls per frame, at 1080p
+    static const int SCROLL_STEP = 4;
+
+    SyntheticSource(cv::Size size, double fps = DEFAULT_FPS, unsigned int seed = 1);
+
+    bool open();
+    bool isOpened() const;
+    bool read(cv::Mat & frame);
+    void release();
+    double getFps() const;
+    QString getName() const;
+};
+
+#endif // SYNTHETICSOURCE_H
@@ -0,0 +1,47 @@
+# Golden-image regression tests of the image pipeline (see README). Build in release mode to enforce time budgets
+QT       += core gui testlib
+QT       -= widgets
+
+CONFIG   += console c++11 testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_imagepipeline
+TEMPLATE = app
+
+INCLUDEPATH += ..
+DEFINES += SOURCE_DIR=\\\"$$PWD\\\"
+
+# OpenCV from pkg-config, or from OPENCV_DIR (the OpenCV build folder set up as in the README)
+isEmpty(OPENCV_DIR): OPENCV_DIR = $$(OPENCV_DIR)
+unix:isEmpty(OPENCV_DIR) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv
+}
+else {
+    INCLUDEPATH += $$OPENCV_DIR/install/include
+    OPENCV_MODULES = core imgproc imgcodecs
+    for(module, OPENCV_MODULES) {
+        win32: LIBS += $$OPENCV_DIR/bin/libopencv_$${module}320.dll
+        else: LIBS += -L$$OPENCV_DIR/install/lib -lopencv_$${module}
+    }
+}
+
+SOURCES += \
+    tst_imagepipeline.cpp \
+    ../binaryimage.cpp \
+    ../imagepipeline.cpp \
+    ../framesource.cpp \
+    ../syntheticsource.cpp \
+    ../pipelinemetrics.cpp \
+    ../latencyhistogram.cpp \
+    ../tracer.cpp
+
+HEADERS += \
+    ../binaryimage.h \
+    ../imagepipeline.h \
+    ../imagesettings.h \
+    ../framesource.h \
+    ../syntheticsource.h \
+    ../pipelinemetrics.h \
+    ../latencyhistogram.h \
+    ../tracer.h
@@ -0,0 +1,334 @@
+#include "../binaryimage.h"
+#include "../imagepipeline.h"
+#include "../syntheticsource.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QtTest>
+
+#include <opencv2/imgcodecs.hpp>
+
+/*
+ * Runs a fixed corpus of pages through every filter & rotation angle, and compares the results against
+ * golden images (within a small tolerance, since image decoding and resampling can vary slightly between
+ * OpenCV builds). Each configuration must also stay within its time budget in release builds.
+ *
+ * Goldens & budgets are created from a trusted build by running with UPDATE_GOLDENS=1. Packing of black & white
+ * results (how snapshots & document pages are kept) is checked by round trip
+ */
+class TestImagePipeline : public QObject {
+    Q_OBJECT
+
+private:
+    QDir goldenDir;
+    bool isUpdating = false;
+    QMap<QString, cv::Mat> corpus;
+    QJsonObject budgets;
+
+    QString getGoldenPath(const QString & name);
+    bool compareImages(const cv::Mat & result, const cv::Mat & golden, QString & error);
+    static cv::Mat processStages(const cv::Mat & input, const ImageSettings & settings);
+
+private slots:
+    void initTestCase();
+    void processImage_data();
+    void processImage();
+    void rotateBeforeTone();
+    void cachedStages();
+    void packBinary_data();
+    void packBinary();
+    void cleanupTestCase();
+
+public:
+    // Largest difference in a channel that counts as the same pixel
+    static const int MAX_PIXEL_DIFFERENCE = 2;
+    // Fraction of pixels allowed to differ more (black & white pixels flip right at the threshold)
+    static constexpr double MAX_DIFFERENT_FRACTION = 0.002;
+
+    // Runs timed per configuration (the median is compared with the budget)
+    static const int TIMED_RUNS = 5;
+    // Budgets are generated as the measured time multiplied by this margin, but at least MIN_BUDGET_MS
+    static const int BUDGET_MARGIN = 3;
+    static const int MIN_BUDGET_MS = 5;
+};
+
+/*
+ * Corpus is the sample image, any page captured into tests/corpus, and generated pages of text
+ */
+void TestImagePipeline::initTestCase() {
+    isUpdating = qEnvironmentVariableIsSet("UPDATE_GOLDENS");
+
+    QDir testDir(SOURCE_DIR);
+    goldenDir = QDir(testDir.filePath("golden"));
+    if (isUpdating) {
+        QVERIFY(goldenDir.mkpath("."));
+    }
+
+    corpus["sample"] = cv::imread(testDir.filePath("../media/sampleImage.jpg").toStdString(), cv::IMREAD_COLOR);
+
+    QDir corpusDir(testDir.filePath("corpus"));
+    QStringList nameFilters = {"*.png", "*.jpg", "*.jpeg", "*.bmp", "*.tif", "*.tiff"};
+    for (const QFileInfo & fileInfo : corpusDir.entryInfoList(nameFilters, QDir::Files, QDir::Name)) {
+        corpus[fileInfo.completeBaseName()] = cv::imread(fileInfo.filePath().toStdString(), cv::IMREAD_COLOR);
+    }
+
+    for (cv::Size size : {cv::Size(1280, 720), cv::Size(1920, 1080)}) {
+        SyntheticSource source(size, 0);
+        cv::Mat page;
+        QVERIFY(source.open() && source.read(page));
+        corpus[QString("synthetic%1p").arg(size.height)] = page;
+    }
+
+    for (auto page = corpus.cbegin(); page != corpus.cend(); ++page) {
+        QVERIFY2(!page.value().empty(), qPrintable("Cannot read corpus page " + page.key()));
+    }
+
+    QFile budgetFile(goldenDir.filePath("budgets.json"));
+    if (budgetFile.open(QFile::ReadOnly)) {
+        budgets = QJsonDocument::fromJson(budgetFile.readAll()).object();
+    }
+}
+
+void TestImagePipeline::processImage_data() {
+    QTest::addColumn<QString>("page");
+    QTest::addColumn<int>("angle");
+    QTest::addColumn<QString>("filter");
+    QTest::addColumn<bool>("isColor");
+
+    for (const QString & page : corpus.keys()) {
+        for (int angle : {0, 5, 45, 90, 135, 180, 270}) {
+            for (const QString & filter : {"None", "Greyscale", "Black and White"}) {
+                for (bool isColor : {true, false}) {
+                    QString name = QString("%1_%2deg_%3_%4").arg(page).arg(angle).arg(filter)
+                            .arg(isColor ? "colour" : "grey");
+                    QTest::newRow(qPrintable(name.replace(' ', '-'))) << page << angle << filter << isColor;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Compare the output for one configuration with its golden, and its time with its budget
+ */
+void TestImagePipeline::processImage() {
+    QFETCH(QString, page);
+    QFETCH(int, angle);
+    QFETCH(QString, filter);
+    QFETCH(bool, isColor);
+
+    cv::Mat input = corpus[page];
+    if (!isColor) {
+        cv::cvtColor(input, input, CV_BGR2GRAY);
+    }
+
+    // Contrast stretch & brightness are part of every configuration, since the black & white threshold follows them
+    ImageSettings settings;
+    settings.contrast = 1.3;
+    settings.brightness = 15;
+    settings.angle = angle;
+    settings.filter = filter.toStdString();
+
+    std::vector<qint64> times;
+    cv::Mat result;
+    for (int i = 0; i < TIMED_RUNS; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        result = ImagePipeline::processImage(input, settings);
+        times.push_back(timer.nsecsElapsed());
+    }
+    std::sort(times.begin(), times.end());
+    double medianMs = times[times.size() / 2] / 1e6;
+
+    // Cached pipeline (used for snapshots) must give exactly the same result as its stages run in order
+    ImagePipeline pipeline;
+    pipeline.setSource(input);
+    cv::Mat cachedResult = pipeline.process(settings);
+    cv::Mat stagesResult = processStages(input, settings);
+    QCOMPARE(cachedResult.size(), stagesResult.size());
+    QCOMPARE(cachedResult.type(), stagesResult.type());
+    QCOMPARE(cv::norm(cachedResult, stagesResult, cv::NORM_INF), 0.0);
+
+    QString name = QTest::currentDataTag();
+    if (isUpdating) {
+        QVERIFY(cv::imwrite(getGoldenPath(name).toStdString(), result));
+        budgets[name] = std::max(double(MIN_BUDGET_MS), std::ceil(medianMs * BUDGET_MARGIN));
+        return;
+    }
+
+    cv::Mat golden = cv::imread(getGoldenPath(name).toStdString(), cv::IMREAD_UNCHANGED);
+    if (golden.empty()) {
+        QFAIL(qPrintable("Missing golden " + getGoldenPath(name) + " (run with UPDATE_GOLDENS=1)"));
+    }
+    QString error;
+    QVERIFY2(compareImages(result, golden, error), qPrintable(error));
+
+#ifdef QT_DEBUG
+    Q_UNUSED(medianMs);
+#else
+    if (!budgets.contains(name)) {
+        QFAIL(qPrintable("Missing budget for " + name + " (run with UPDATE_GOLDENS=1)"));
+    }
+    double budgetMs = budgets[name].toDouble();
+    QVERIFY2(medianMs <= budgetMs, qPrintable(QString("Took %1 ms, over the budget of %2 ms").arg(medianMs).arg(budgetMs)));
+#endif
+}
+
+/*
+ * Snapshots (rotated before the tone adjustment, so that tone changes reuse the rotation) must look the same
+ * as video frames (tone adjusted first), including the edges & black corners, while no pixel saturates
+ */
+void TestImagePipeline::rotateBeforeTone() {
+    // Values low enough that contrast & brightness never saturate
+    cv::Mat input(480, 640, CV_8UC3);
+    cv::randu(input, cv::Scalar::all(0), cv::Scalar::all(150));
+
+    ImageSettings settings;
+    settings.contrast = 1.3;
+    settings.brightness = 15;
+
+    for (int angle : {5, 45, 90, 135}) {
+        settings.angle = angle;
+        ImagePipeline pipeline;
+        pipeline.setSource(input);
+        cv::Mat snapshot = pipeline.process(settings);
+        cv::Mat frame = ImagePipeline::processImage(input, settings);
+
+        QString error;
+        QVERIFY2(compareImages(snapshot, frame, error), qPrintable(QString("%1 degrees: %2").arg(angle).arg(error)));
+    }
+}
+
+/*
+ * Cached pipeline must match running its stages from scratch as settings change one at a time, in any order
+ */
+void TestImagePipeline::cachedStages() {
+    cv::Mat input = corpus.first();
+    ImagePipeline pipeline;
+    pipeline.setSource(input);
+
+    ImageSettings settings;
+    QList<std::function<void()>> changes = {
+        [&settings]() { settings.brightness = 20; },
+        [&settings]() { settings.angle = 90; },
+        [&settings]() { settings.filter = "Black and White"; },
+        [&settings]() { settings.contrast = 1.5; },
+        [&settings]() { settings.angle = 270; },
+        [&settings]() { settings.filter = "Greyscale"; },
+        [&settings]() { settings.scale = 0.5; },
+        [&settings]() { settings.brightness = 0; },
+    };
+    for (const std::function<void()> & change : changes) {
+        change();
+        cv::Mat cachedResult = pipeline.process(settings);
+        cv::Mat result = processStages(input, settings);
+        QCOMPARE(cachedResult.size(), result.size());
+        QCOMPARE(cachedResult.type(), result.type());
+        QCOMPARE(cv::norm(cachedResult, result, cv::NORM_INF), 0.0);
+    }
+}
+
+void TestImagePipeline::packBinary_data() {
+    QTest::addColumn<int>("width");
+
+    // Rows that end part way through a byte, as well as whole bytes
+    for (int width : {1, 7, 8, 9, 13, 16, 1001}) {
+        QTest::newRow(qPrintable(QString("%1 pixels wide").arg(width))) << width;
+    }
+}
+
+/*
+ * Black & white images must come back unchanged once packed to 1 bit per pixel & unpacked, whole or by region
+ */
+void TestImagePipeline::packBinary() {
+    QFETCH(int, width);
+
+    cv::Mat noise(5, width, CV_8UC1);
+    cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::Mat binary;
+    cv::threshold(noise, binary, 127, 255, cv::THRESH_BINARY);
+
+    QImage packed = BinaryImage::pack(binary);
+    QCOMPARE(packed.format(), QImage::Format_Mono);
+    QCOMPARE(packed.size(), QSize(width, binary.rows));
+
+    cv::Mat unpacked = BinaryImage::unpack(packed);
+    QCOMPARE(unpacked.size(), binary.size());
+    QCOMPARE(cv::norm(unpacked, binary, cv::NORM_INF), 0.0);
+
+    QRect region(width / 3, 1, width - width / 3, 3);
+    cv::Mat unpackedRegion = BinaryImage::unpack(packed, region);
+    cv::Mat binaryRegion = binary(cv::Rect(region.x(), region.y(), region.width(), region.height()));
+    QCOMPARE(cv::norm(unpackedRegion, binaryRegion, cv::NORM_INF), 0.0);
+
+    QImage expanded = BinaryImage::expand(packed);
+    QCOMPARE(expanded.format(), QImage::Format_Grayscale8);
+    for (int y = 0; y < binary.rows; y++) {
+        QVERIFY(std::equal(binary.ptr(y), binary.ptr(y) + width, expanded.constScanLine(y)));
+    }
+}
+
+/*
+ * Save the budgets measured while updating goldens
+ */
+void TestImagePipeline::cleanupTestCase() {
+    if (!isUpdating) {
+        return;
+    }
+
+    QFile budgetFile(goldenDir.filePath("budgets.json"));
+    QVERIFY(budgetFile.open(QFile::WriteOnly));
+    QVERIFY(budgetFile.write(QJsonDocument(budgets).toJson()) >= 0);
+}
+
+/*
+ * Stages of the cached pipeline run in order without caching: rotation, tone weighted by coverage, then filter
+ */
+cv::Mat TestImagePipeline::processStages(const cv::Mat & input, const ImageSettings & settings) {
+    cv::Mat scaled = ImagePipeline::scale(input, settings.scale);
+    cv::Mat rotated = ImagePipeline::rotate(scaled, settings.angle, settings.interpolation);
+    cv::Mat coverage = ImagePipeline::getCoverage(scaled.size(), settings.angle, settings.interpolation);
+    cv::Mat adjusted = ImagePipeline::adjustTone(rotated, coverage, settings.contrast, settings.brightness);
+    return ImagePipeline::applyFilter(adjusted, settings.filter);
+}
+
+QString TestImagePipeline::getGoldenPath(const QString & name) {
+    return goldenDir.filePath(name + ".png");
+}
+
+/*
+ * Whether the result has the same size & format as the golden, and nearly the same pixels
+ */
+bool TestImagePipeline::compareImages(const cv::Mat & result, const cv::Mat & golden, QString & error) {
+    if (result.size() != golden.size() || result.type() != golden.type()) {
+        error = QString("Result is %1x%2 with %3 channel(s), golden is %4x%5 with %6 channel(s)")
+                .arg(result.cols).arg(result.rows).arg(result.channels())
+                .arg(golden.cols).arg(golden.rows).arg(golden.channels());
+        return false;
+    }
+
+    cv::Mat difference;
+    cv::absdiff(result, golden, difference);
+    difference = difference.reshape(1);
+    double differentFraction = double(cv::countNonZero(difference > MAX_PIXEL_DIFFERENCE)) / difference.total();
+    if (differentFraction > MAX_DIFFERENT_FRACTION) {
+        error = QString("%1% of pixel values differ from the golden").arg(differentFraction * 100, 0, 'f', 3);
+        return false;
+    }
+
+    return true;
+}
+
+QTEST_GUILESS_MAIN(TestImagePipeline)
+
+#include "tst_imagepipeline.moc"
@@ -0,0 +1,83 @@
+#include "tiledimageitem.h"
+
+TiledImageItem::TiledImageItem(QGraphicsItem * parent)
+    : QGraphicsItem(parent) {
+    // To only be asked to paint the area that is exposed
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+void TiledImageItem::setPyramid(QSharedPointer<TilePyramid> pyramid) {
+    prepareGeometryChange();
+    this->pyramid = pyramid;
+    update();
+}
+
+QSharedPointer<TilePyramid> TiledImageItem::getPyramid() const {
+    return pyramid;
+}
+
+/*
+ * Area of the full resolution image
+ */
+QRectF TiledImageItem::boundingRect() const {
+    if (pyramid.isNull()) {
+        return QRectF();
+    }
+
+    return QRectF(QPointF(0, 0), pyramid->getSize());
+}
+
+/*
+ * Draw exposed tiles from the smallest level that still has enough detail for the current zoom
+ */
+void TiledImageItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget) {
+    Q_UNUSED(widget);
+
+    if (pyramid.isNull() || pyramid->isEmpty()) {
+        return;
+    }
+
+    QTransform transform = painter->worldTransform();
+    double scale = qSqrt(transform.m11() * transform.m11() + transform.m12() * transform.m12());
+    int levelIndex = pyramid->getLevelForScale(scale);
+    const TilePyramid::Level & level = pyramid->getLevel(levelIndex);
+
+    // Size of a level pixel in full resolution pixels
+    QSize size = pyramid->getSize();
+    double scaleX = double(size.width()) / level.size.width();
+    double scaleY = double(size.height()) / level.size.height();
+    double tileWidth = TilePyramid::TILE_SIZE * scaleX;
+    double tileHeight = TilePyramid::TILE_SIZE * scaleY;
+
+    QRectF exposed = option->exposedRect & boundingRect();
+    int firstColumn = qMax(0, int(exposed.left() / tileWidth));
+    int lastColumn = qMin(level.columns - 1, int(exposed.right() / tileWidth));
+    int firstRow = qMax(0, int(exposed.top() / tileHeight));
+    int lastRow = qMin(level.rows - 1, int(exposed.bottom() / tileHeight));
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            QRect source = pyramid->getTileRect(levelIndex, column, row);
+            QRectF target(source.x() * scaleX, source.y() * scaleY, source.width() * scaleX, source.height() * scaleY);
+            painter->drawPixmap(target, getTilePixmap(levelIndex, column, row), QRectF(0, 0, source.width(), source.height()));
+        }
+    }
+}
+
+/*
+ * Tile converted for drawing, cached so that panning over it again doesn't convert it again
+ */
+QPixmap TiledImageItem::getTilePixmap(int level, int column, int row) {
+    QString key = QString("tile_%1_%2_%3_%4").arg(pyramid->getId()).arg(level).arg(column).arg(row);
+
+    QPixmap pixmap;
+    if (!QPixmapCache::find(key, &pixmap)) {
+        const TilePyramid::Level & tileLevel = pyramid->getLevel(level);
+        const QImage & tile = tileLevel.tiles.at(row * tileLevel.columns + column);
+        // Packed black & white tiles are only expanded once they are visible (a 1 bit pixmap is drawn as a mask)
+        pixmap = QPixmap::fromImage(BinaryImage::expand(tile));
+        QPixmapCache::insert(key, pixmap);
+    }
+
+    return pixmap;
+}
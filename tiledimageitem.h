@@ -0,0 +1,37 @@
+#ifndef TILEDIMAGEITEM_H
+#define TILEDIMAGEITEM_H
+
+// Parent class
+#include <QGraphicsItem>
+
+// Implementation classes
+#include <QPainter>
+#include <QPixmap>
+#include <QPixmapCache>
+#include <QSharedPointer>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+#include "binaryimage.h"
+#include "tilepyramid.h"
+
+/*
+ * Draws a tile pyramid, using only the tiles that are exposed at the level matching the view's zoom
+ */
+class TiledImageItem : public QGraphicsItem {
+
+private:
+    QSharedPointer<TilePyramid> pyramid;
+
+    QPixmap getTilePixmap(int level, int column, int row);
+
+public:
+    TiledImageItem(QGraphicsItem * parent = nullptr);
+
+    void setPyramid(QSharedPointer<TilePyramid> pyramid);
+    QSharedPointer<TilePyramid> getPyramid() const;
+    QRectF boundingRect() const;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr);
+};
+
+#endif // TILEDIMAGEITEM_H
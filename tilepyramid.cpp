@@ -0,0 +1,135 @@
+#include "tilepyramid.h"
+
+QAtomicInt TilePyramid::nextId(1);
+
+/*
+ * Empty pyramid for the image with the given cache key
+ */
+TilePyramid::TilePyramid(qint64 sourceKey) {
+    this->id = nextId.fetchAndAddRelaxed(1);
+    this->sourceKey = sourceKey;
+}
+
+/*
+ * Split image into tiles and add it as the next (smaller) level of the pyramid
+ */
+void TilePyramid::addLevel(const QImage & img) {
+    Level level;
+    level.size = img.size();
+    level.columns = (img.width() + TILE_SIZE - 1) / TILE_SIZE;
+    level.rows = (img.height() + TILE_SIZE - 1) / TILE_SIZE;
+    level.tiles.reserve(level.columns * level.rows);
+
+    for (int row = 0; row < level.rows; row++) {
+        for (int column = 0; column < level.columns; column++) {
+            QRect tileRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+            level.tiles.append(img.copy(tileRect & img.rect()));
+        }
+    }
+
+    levels.append(level);
+}
+
+/*
+ * Add the next level from tiles that are already split (row-major, TILE_SIZE apart), e.g. read from a file
+ */
+void TilePyramid::addLevel(QSize size, const QVector<QImage> & tiles) {
+    Level level;
+    level.size = size;
+    level.columns = (size.width() + TILE_SIZE - 1) / TILE_SIZE;
+    level.rows = (size.height() + TILE_SIZE - 1) / TILE_SIZE;
+    level.tiles = tiles;
+
+    levels.append(level);
+}
+
+bool TilePyramid::isEmpty() const {
+    return levels.isEmpty();
+}
+
+int TilePyramid::getLevelCount() const {
+    return levels.count();
+}
+
+const TilePyramid::Level & TilePyramid::getLevel(int level) const {
+    return levels.at(level);
+}
+
+/*
+ * Size of the full resolution image
+ */
+QSize TilePyramid::getSize() const {
+    return levels.isEmpty() ? QSize() : levels.first().size;
+}
+
+/*
+ * Identifier that is unique to this pyramid (e.g. for caching tiles)
+ */
+qint64 TilePyramid::getId() const {
+    return id;
+}
+
+/*
+ * Cache key of the image the pyramid was built from
+ */
+qint64 TilePyramid::getSourceKey() const {
+    return sourceKey;
+}
+
+/*
+ * Smallest level that still has at least one pixel per screen pixel when drawn at the given scale
+ */
+int TilePyramid::getLevelForScale(double scale) const {
+    if (levels.isEmpty() || scale >= 1) {
+        return 0;
+    }
+
+    int level = int(std::floor(-std::log2(scale)));
+    return qBound(0, level, levels.count() - 1);
+}
+
+/*
+ * Area covered by a tile, in pixels of its level
+ */
+QRect TilePyramid::getTileRect(int level, int column, int row) const {
+    const Level & tileLevel = levels.at(level);
+    QRect tileRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+    return tileRect & QRect(QPoint(0, 0), tileLevel.size);
+}
+
+/*
+ * Convert image to a format that can be both downsampled and drawn quickly
+ */
+QImage TilePyramid::normalizeFormat(const QImage & img) {
+    switch (img.format()) {
+        case QImage::Format_RGB32 :
+        case QImage::Format_RGB888 :
+        case QImage::Format_Grayscale8 :
+        // Black & white images stay packed at full resolution
+        case QImage::Format_Mono :
+            return img;
+        case QImage::Format_Indexed8 :
+            // Indexed images without a colour table are really greyscale
+            return QImage(img.constBits(), img.width(), img.height(), img.bytesPerLine(),
+                          QImage::Format_Grayscale8).copy();
+        default:
+            return img.convertToFormat(QImage::Format_RGB32);
+    }
+}
+
+/*
+ * Halve the size of an image by averaging each 2x2 block of pixels
+ */
+QImage TilePyramid::downsample(const QImage & img) {
+    // Halved black & white images become grey, so that text stays smooth when zoomed out
+    bool isPacked = (img.format() == QImage::Format_Mono);
+    QImage result((img.width() + 1) / 2, (img.height() + 1) / 2, isPacked ? QImage::Format_Grayscale8 : img.format());
+
+    int type = (img.depth() == 32) ? CV_8UC4 : (img.depth() == 24) ? CV_8UC3 : CV_8UC1;
+    cv::Mat src = isPacked ? BinaryImage::unpack(img)
+                           : cv::Mat(img.height(), img.width(), type, const_cast<uchar *>(img.constBits()), size_t(img.bytesPerLine()));
+    cv::Mat dst(result.height(), result.width(), type, result.bits(), size_t(result.bytesPerLine()));
+    cv::resize(src, dst, dst.size(), 0, 0, cv::INTER_AREA);
+
+    return result;
+}
@@ -0,0 +1,59 @@
+#ifndef TILEPYRAMID_H
+#define TILEPYRAMID_H
+
+// Implementation classes
+#include <cmath>
+
+#include <QAtomicInt>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "binaryimage.h"
+
+/*
+ * Image stored as a stack of progressively halved copies (mipmaps), each split into square tiles,
+ * so that only the visible tiles at the resolution needed for the current zoom have to be drawn
+ */
+class TilePyramid {
+
+public:
+    struct Level {
+        QSize size;
+        int columns = 0;
+        int rows = 0;
+        // Row-major tiles of this level
+        QVector<QImage> tiles;
+    };
+
+    static const int TILE_SIZE = 512;
+
+    TilePyramid(qint64 sourceKey = 0);
+
+    void addLevel(const QImage & img);
+    void addLevel(QSize size, const QVector<QImage> & tiles);
+    bool isEmpty() const;
+    int getLevelCount() const;
+    const Level & getLevel(int level) const;
+    QSize getSize() const;
+    qint64 getId() const;
+    qint64 getSourceKey() const;
+    int getLevelForScale(double scale) const;
+    QRect getTileRect(int level, int column, int row) const;
+
+    static QImage normalizeFormat(const QImage & img);
+    static QImage downsample(const QImage & img);
+
+private:
+    static QAtomicInt nextId;
+
+    qint64 id;
+    qint64 sourceKey;
+    QVector<Level> levels;
+};
+
+#endif // TILEPYRAMID_H
@@ -0,0 +1,103 @@
+#include "tracer.h"
+
+std::atomic<bool> Tracer::enabled(false);
+QMutex Tracer::buffersMutex;
+std::vector<std::shared_ptr<Tracer::ThreadBuffer>> Tracer::buffers;
+
+void Tracer::setEnabled(bool isEnabled) {
+    enabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+/*
+ * Add an event to the calling thread's buffer. Times are from PipelineMetrics::now()
+ */
+void Tracer::record(const char * name, qint64 begin, qint64 end) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    ThreadBuffer * buffer = getThreadBuffer();
+    quint64 written = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[written % BUFFER_EVENTS] = Event{name, begin, end};
+    // Publish the event to dump()
+    buffer->written.store(written + 1, std::memory_order_release);
+}
+
+/*
+ * Buffer of the calling thread, created the first time the thread records an event. Buffers are kept
+ * after their thread finishes, so that its events can still be written out
+ */
+Tracer::ThreadBuffer * Tracer::getThreadBuffer() {
+    thread_local ThreadBuffer * threadBuffer = nullptr;
+    if (threadBuffer == nullptr) {
+        std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+        buffer->threadId = quint64(quintptr(QThread::currentThreadId()));
+        QThread * thread = QThread::currentThread();
+        buffer->threadName = !thread->objectName().isEmpty()
+                ? thread->objectName()
+                : QString(thread->metaObject()->className());
+        buffer->events.resize(BUFFER_EVENTS);
+        buffer->written.store(0);
+
+        buffersMutex.lock();
+        buffers.push_back(buffer);
+        buffersMutex.unlock();
+
+        threadBuffer = buffer.get();
+    }
+
+    return threadBuffer;
+}
+
+/*
+ * Forget every event recorded so far. Only call while tracing is off
+ */
+void Tracer::clear() {
+    buffersMutex.lock();
+    for (const std::shared_ptr<ThreadBuffer> & buffer : buffers) {
+        buffer->written.store(0, std::memory_order_release);
+    }
+    buffersMutex.unlock();
+}
+
+/*
+ * Write the events of every thread as a Chrome trace (JSON). Tracing should be off, so that events
+ * aren't overwritten while being written out
+ */
+bool Tracer::dump(const QString & path) {
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool isFirst = true;
+
+    buffersMutex.lock();
+    for (const std::shared_ptr<ThreadBuffer> & buffer : buffers) {
+        quint64 written = buffer->written.load(std::memory_order_acquire);
+        quint64 first = (written > quint64(BUFFER_EVENTS)) ? written - BUFFER_EVENTS : 0;
+
+        QString threadName = buffer->threadName;
+        threadName.replace('\\', "\\\\").replace('"', "\\\"");
+        out << (isFirst ? "" : ",")
+            << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":\"" << threadName << "\"}}";
+        isFirst = false;
+
+        // Complete events, with times in microseconds
+        for (quint64 i = first; i < written; i++) {
+            const Event & event = buffer->events[i % BUFFER_EVENTS];
+            out << ",{\"ph\":\"X\",\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << QString::number(event.begin / 1000.0, 'f', 3)
+                << ",\"dur\":" << QString::number((event.end - event.begin) / 1000.0, 'f', 3) << "}";
+        }
+    }
+    buffersMutex.unlock();
+
+    out << "]}";
+    out.flush();
+
+    return out.status() == QTextStream::Ok && file.error() == QFile::NoError;
+}
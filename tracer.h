@@ -0,0 +1,87 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+// Implementation classes
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QTextStream>
+#include <QThread>
+
+#include "pipelinemetrics.h"
+
+// Record how long the rest of the enclosing scope takes, under the given name (a string literal)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_CONCAT_INNER(a, b) a##b
+
+/*
+ * Records when named events begin and end on each thread, to find occasional stalls that averages hide.
+ * Each thread writes to its own ring buffer without locking, keeping only its latest BUFFER_EVENTS events,
+ * and the buffers are written out in Chrome's trace format (for chrome://tracing or Perfetto) on demand.
+ * While tracing is off, recording costs a single relaxed atomic load
+ */
+class Tracer {
+
+public:
+    struct Event {
+        // String literal, so only the pointer is kept
+        const char * name;
+        qint64 begin;
+        qint64 end;
+    };
+
+    static const int BUFFER_EVENTS = 1 << 14;
+
+private:
+    struct ThreadBuffer {
+        quint64 threadId;
+        QString threadName;
+        std::vector<Event> events;
+        // Number of events ever written (the oldest are overwritten once the buffer is full)
+        std::atomic<quint64> written;
+    };
+
+    static std::atomic<bool> enabled;
+    static QMutex buffersMutex;
+    static std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    static ThreadBuffer * getThreadBuffer();
+
+public:
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    static void setEnabled(bool isEnabled);
+    static void record(const char * name, qint64 begin, qint64 end);
+    static void clear();
+    static bool dump(const QString & path);
+};
+
+/*
+ * Records an event from its construction to its destruction, if tracing is on when it's constructed
+ */
+class TraceScope {
+
+private:
+    const char * name;
+    qint64 begin;
+
+public:
+    explicit TraceScope(const char * name)
+        : name(name), begin(Tracer::isEnabled() ? PipelineMetrics::now() : -1) {
+    }
+
+    ~TraceScope() {
+        if (begin >= 0) {
+            Tracer::record(name, begin, PipelineMetrics::now());
+        }
+    }
+};
+
+#endif // TRACER_H
@@ -0,0 +1,51 @@
+#include "videofilesource.h"
+
+VideoFileSource::VideoFileSource(const QString & path, bool isLooping, bool isPaced) {
+    this->path = path;
+    this->isLooping = isLooping;
+    this->isPaced = isPaced;
+}
+
+bool VideoFileSource::open() {
+    if (!capture.open(path.toStdString())) {
+        return false;
+    }
+
+    fps = capture.get(cv::CAP_PROP_FPS);
+    if (fps <= 0) {
+        fps = DEFAULT_FPS;
+    }
+
+    return true;
+}
+
+bool VideoFileSource::isOpened() const {
+    return capture.isOpened();
+}
+
+bool VideoFileSource::read(cv::Mat & frame) {
+    pace(isPaced ? fps : 0);
+
+    if (capture.read(frame)) {
+        return true;
+    }
+    if (!isLooping) {
+        return false;
+    }
+
+    // Start over from the first frame
+    capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+    return capture.read(frame);
+}
+
+void VideoFileSource::release() {
+    capture.release();
+}
+
+double VideoFileSource::getFps() const {
+    return isPaced ? fps : 0;
+}
+
+QString VideoFileSource::getName() const {
+    return QString("video %1").arg(path);
+}
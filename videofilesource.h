@@ -0,0 +1,36 @@
+#ifndef VIDEOFILESOURCE_H
+#define VIDEOFILESOURCE_H
+
+// Parent class
+#include "framesource.h"
+
+// Implementation classes
+#include <opencv2/videoio.hpp>
+
+/*
+ * Recorded video played at its own frame rate (or as fast as possible), starting over at the end if looping
+ */
+class VideoFileSource : public FrameSource {
+
+private:
+    QString path;
+    bool isLooping;
+    bool isPaced;
+    double fps = 0;
+    cv::VideoCapture capture;
+
+public:
+    // Used when the file doesn't tell its frame rate
+    static constexpr double DEFAULT_FPS = 30;
+
+    VideoFileSource(const QString & path, bool isLooping = true, bool isPaced = true);
+
+    bool open();
+    bool isOpened() const;
+    bool read(cv::Mat & frame);
+    void release();
+    double getFps() const;
+    QString getName() const;
+};
+
+#endif // VIDEOFILESOURCE_H
@@ -3,33 +3,105 @@
 WebcamPlayer::WebcamPlayer(QObject * parent)
     : QThread(parent) {
     stop();
-    brightness = 0;
-    contrast = 1;
+    opener = new CaptureOpener(this);
+    metrics = PipelineMetrics::instance();
 }
 
 /*
- * Open webcam device from index (0 for default webcam). Closes the already opened device
+ * Open webcam device from index (0 for default webcam), closing the already opened device
  */
-bool WebcamPlayer::open(int device) {
-    release();
-
+void WebcamPlayer::open(int device) {
     curWebcam = device;
+    open(makePtr<CameraSource>(device));
+}
+
+/*
+ * Open frame source, closing the already opened one. The source is opened (and warmed up) in the
+ * background while the old one keeps playing, then the player switches to it between two frames.
+ * A webcam can't be opened twice, so the old source is closed first if it's the same device
+ */
+void WebcamPlayer::open(Ptr<FrameSource> newSource) {
+    suspendedSource.release();
+
+    mutex.lock();
+    requestedSource = newSource;
+    mutex.unlock();
+
+    // Otherwise the player thread starts opening it (the old source can only be closed from there)
+    if (!isRunning()) {
+        openRequestedSource();
+    }
+}
+
+/*
+ * Start opening the requested source, if any, first closing the source being played if it's on the
+ * same device. Only called while no other thread reads from the source. Returns whether one was requested
+ */
+bool WebcamPlayer::openRequestedSource() {
+    mutex.lock();
+    Ptr<FrameSource> newSource = requestedSource;
+    requestedSource.release();
+    mutex.unlock();
 
-    // Open new webcam && return result
-    int isOpened = capture.open(device);
-    useMaxResolution();
-    return isOpened;
+    if (newSource.empty()) {
+        return false;
+    }
+
+    if (!source.empty() && newSource->getDevice() >= 0 && newSource->getDevice() == source->getDevice()) {
+        source->release();
+        source.release();
+    }
+    opener->open(newSource);
+    return true;
+}
+
+/*
+ * Switch to the source that finished opening, if any. Returns false if it couldn't be opened
+ */
+bool WebcamPlayer::switchSource() {
+    Ptr<FrameSource> newSource;
+    if (!opener->takeSource(newSource)) {
+        return true;
+    }
+    if (newSource.empty()) {
+        return false;
+    }
+
+    // Old source is released here, on the thread that was reading from it
+    source = newSource;
+    governor.reset();
+    metrics->setQualityLevel(governor.getLevel());
+    return true;
 }
 
 /*
  * Start emitting frame data (via processedImage(QImage))
  */
 void WebcamPlayer::play() {
+    // Thread is finishing its last frame after being stopped, so it can't carry on
+    if (isRunning() && isStopped()) {
+        wait();
+    }
+
     if (!isRunning()) {
         if (isStopped()) {
             stopped = false;
         }
 
+        // Reopen suspended source in the background (the player waits for it), unless another one
+        // was requested after the player stopped
+        if (openRequestedSource()) {
+            suspendedSource.release();
+        }
+        else if (!suspendedSource.empty()) {
+            opener->open(suspendedSource);
+            suspendedSource.release();
+        }
+        // First frame is always shown, and frames from before stopping aren't
+        lastThumbnail.release();
+        nextFrameDue = 0;
+        mailbox.clear();
+
         // Start running thread
         start(LowPriority);
     }
@@ -40,74 +112,177 @@ void WebcamPlayer::play() {
  */
 void WebcamPlayer::run() {
     while (!stopped) {
+        openRequestedSource();
+        if (!switchSource()) {
+            stop();
+            emit readError();
+            break;
+        }
+
+        // Nothing to read until the first source finishes opening
+        if (source.empty() && opener->isOpening()) {
+            opener->waitForSource(OPEN_WAIT_MS);
+            continue;
+        }
+
         // Get next frame of video
-        bool isRead = capture.read(frame);
-        if (!isRead) {
+        qint64 readStart = PipelineMetrics::now();
+        bool isRead = !source.empty() && source->read(frame);
+        if (!isRead && opener->isOpening()) {
+            // Source was lost, but another one is on its way
+            source.release();
+            continue;
+        }
+        else if (!isRead) {
             stop();
             emit readError();
             break;
         }
+        qint64 capturedAt = PipelineMetrics::now();
+        metrics->record(PipelineMetrics::READ, capturedAt - readStart);
+        Tracer::record("Capture read", readStart, capturedAt);
+
+        // Add frame to the page mosaic, and show the mosaic instead of the frame
+        // (stitching is done outside the lock, so that it can be turned off without waiting for it)
+        mutex.lock();
+        bool isStitching = stitching;
+        bool isStitchingReset = stitchingReset;
+        stitchingReset = false;
+        mutex.unlock();
+        if (isStitching) {
+            stitcherMutex.lock();
+            if (isStitchingReset) {
+                stitcher.reset();
+            }
+            Mat overview;
+            if (stitcher.addFrame(frame)) {
+                overview = stitcher.getOverview();
+            }
+            stitcherMutex.unlock();
+
+            if (!overview.empty()) {
+                processedImage = convertMatToQImage(processImage(overview));
+                postFrame(capturedAt, PipelineMetrics::now());
+            }
+            continue;
+        }
 
-        // Save unmodified image
-        rawImage = convertMatToQImage(frame);
-        emit imageRead(rawImage);
+        // Frames that would be replaced before the display shows them are never processed
+        if (!isFrameDue(capturedAt)) {
+            metrics->countFrameSkipped();
+            continue;
+        }
 
-        // Process frame and save modified image
-        frame = processImage(frame);
-        processedImage = convertMatToQImage(frame);
-        emit imageProcessed(processedImage);
+        // Process frame (at lower quality if processing falls behind) and save modified image
+        // (the unmodified frame is kept for snapshots)
+        ImageSettings frameSettings = getImageSettings();
+        governor.apply(frameSettings);
+
+        // Nothing new to show while the page is still (and the settings didn't change)
+        Mat thumbnail = makeThumbnail(frame);
+        if (skippingUnchanged && !lastThumbnail.empty() && frameSettings == lastSettings
+                && !isThumbnailChanged(thumbnail, lastThumbnail)) {
+            metrics->countFrameUnchanged();
+            continue;
+        }
+        lastThumbnail = thumbnail;
+        lastSettings = frameSettings;
+
+        qint64 processStart = PipelineMetrics::now();
+        Mat processed = ImagePipeline::processImage(frame, frameSettings, metrics);
+        qint64 convertStart = PipelineMetrics::now();
+        // Live frames stay one byte per pixel: packing them would only add to the time the governor sees
+        processedImage = convertMatToQImage(processed);
+        qint64 processedAt = PipelineMetrics::now();
+        metrics->record(PipelineMetrics::CONVERT, processedAt - convertStart);
+        Tracer::record("Convert", convertStart, processedAt);
+        postFrame(capturedAt, processedAt);
+
+        // Processing only has to keep up with the frames that are shown
+        double fps = (source->getFps() > 0) ? source->getFps() : DEFAULT_SOURCE_FPS;
+        qint64 interval = frameInterval;
+        if (interval > 0) {
+            fps = std::min(fps, 1e9 / interval);
+        }
+        if (governor.frameProcessed(processedAt - processStart, fps)) {
+            QualityGovernor::Level level = governor.getLevel();
+            metrics->setQualityLevel(level);
+            qInfo("Video quality: %s", QualityGovernor::getLevelName(level));
+        }
     }
 }
 
 /*
- * Change contrast, brightness, and rotation of image. Convert colors depending on filter string
+ * Whether a frame read at the given time will be presented, given the interval between presented frames.
+ * Frames are taken on a schedule, with half a source frame of slack for jitter, so that (e.g.) a 60 fps
+ * webcam on a 30 Hz display processes every other frame. The schedule never falls behind the source
  */
-Mat WebcamPlayer::processImage(Mat cvImg) {
-    // image' = contrast * image + brightness
-    cvImg.convertTo(cvImg, -1, contrast, brightness);
-
-    // Rotate clockwise by the specified amount of degrees
-    Point2f frameCenter(cvImg.cols/2.0F, cvImg.rows/2.0F);
-    Mat rotMatrix = getRotationMatrix2D(frameCenter, -angle, 1.0);
-    // Determine bounding rectangle
-    Rect2f boundsBox = cv::RotatedRect(cv::Point2f(), cvImg.size(), -angle).boundingRect2f();
-    // Adjust transformation matrix to fit full image
-    rotMatrix.at<double>(0,2) += boundsBox.width/2.0 - cvImg.cols/2.0;
-    rotMatrix.at<double>(1,2) += boundsBox.height/2.0 - cvImg.rows/2.0;
-
-    Mat largerImg(boundsBox.size(), cvImg.type());
-    cvImg.copyTo(largerImg);
-    warpAffine(largerImg, largerImg, rotMatrix, boundsBox.size());
-
-    if (largerImg.channels() == 3) {
-        if (filter == "Greyscale" || filter == "Grayscale") {
-            Mat greyFrame;
-
-            // Convert BGR to single color channel (CV_8UC3 -> CV_8UC1)
-            cv::cvtColor(largerImg, greyFrame, CV_BGR2GRAY);
-
-            return greyFrame;
-        }
-        else if (filter == "Black and White") {
-            Mat monoFrame;
+bool WebcamPlayer::isFrameDue(qint64 capturedAt) {
+    qint64 interval = frameInterval;
+    if (interval <= 0) {
+        return true;
+    }
 
-            // Convert BGR to single color channel (CV_8UC3 -> CV_8UC1)
-            cv::cvtColor(largerImg, monoFrame, CV_BGR2GRAY);
-            // Make any pixel >= 100 white, else black (changing brightness/contrast affects this threshhold)
-            cv::threshold(monoFrame, monoFrame, 100, 255, THRESH_BINARY );
+    double fps = (source->getFps() > 0) ? source->getFps() : DEFAULT_SOURCE_FPS;
+    qint64 slack = qint64(0.5e9 / fps);
+    if (capturedAt + slack < nextFrameDue) {
+        return false;
+    }
 
-            return monoFrame;
-        }
-        else { // filter == "None"
+    nextFrameDue = std::max(nextFrameDue, capturedAt - slack) + interval;
+    return true;
+}
 
-            return largerImg;
-        }
+/*
+ * Leave the processed image for the view, replacing the last one if it wasn't presented yet
+ */
+void WebcamPlayer::postFrame(qint64 capturedAt, qint64 processedAt) {
+    if (mailbox.post(processedImage, capturedAt, processedAt)) {
+        metrics->countFrameDropped();
     }
-    else {
+    emit frameReady();
+}
 
-        return largerImg;
+/*
+ * Small greyscale copy of a frame. Pixels are sampled before being averaged, so that it stays cheap at 8K
+ * while averaging out most of the webcam's noise
+ */
+Mat WebcamPlayer::makeThumbnail(const Mat & img) {
+    Mat sampled;
+    cv::resize(img, sampled, Size(THUMBNAIL_WIDTH * 4, THUMBNAIL_HEIGHT * 4), 0, 0, INTER_NEAREST);
+    if (sampled.channels() == 3) {
+        cv::cvtColor(sampled, sampled, CV_BGR2GRAY);
     }
 
+    Mat thumbnail;
+    cv::resize(sampled, thumbnail, Size(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT), 0, 0, INTER_AREA);
+    return thumbnail;
+}
+
+/*
+ * Whether part of the page moved (or the whole page changed, e.g. the lighting) between two thumbnails
+ */
+bool WebcamPlayer::isThumbnailChanged(const Mat & thumbnail, const Mat & lastThumbnail) {
+    Mat difference;
+    cv::absdiff(thumbnail, lastThumbnail, difference);
+
+    double maxChange = 0;
+    cv::minMaxLoc(difference, nullptr, &maxChange);
+    return maxChange > MAX_PIXEL_CHANGE || cv::mean(difference)[0] > MAX_MEAN_CHANGE;
+}
+
+/*
+ * Process image with the current settings
+ */
+Mat WebcamPlayer::processImage(Mat cvImg) {
+    return ImagePipeline::processImage(cvImg, getImageSettings(), metrics);
+}
+
+/*
+ * Change contrast, brightness, and rotation of image. Convert colors depending on filter string
+ */
+Mat WebcamPlayer::processImage(Mat cvImg, const ImageSettings & settings) {
+    return ImagePipeline::processImage(cvImg, settings);
 }
 
 /*
@@ -126,12 +301,15 @@ Mat WebcamPlayer::convertQImageToMat(QImage QImg) {
                               CV_8UC1, const_cast<uchar*>(QImg.bits()), uint(QImg.bytesPerLine())).clone();
             break;
         }
+        case QImage::Format_Mono :
+            cvImg = BinaryImage::unpack(QImg);
+            break;
         default:
             break;
     }
 
     // Switch from Qt's RGB format to OpenCV's BGR format
-    if (frame.channels() == 3) {
+    if (cvImg.channels() == 3) {
         Mat cvBGRImg;
         cv::cvtColor(cvImg, cvBGRImg, CV_RGB2BGR);
         return cvBGRImg;
@@ -141,7 +319,11 @@ Mat WebcamPlayer::convertQImageToMat(QImage QImg) {
     }
 }
 
-QImage WebcamPlayer::convertMatToQImage(Mat cvImg) {
+/*
+ * Creates a QImage that is a deep copy of the Mat. Black & white images (from the "Black and White" filter)
+ * that are kept, such as snapshots and document pages, are packed to 1 bit per pixel
+ */
+QImage WebcamPlayer::convertMatToQImage(Mat cvImg, bool isBinary) {
     QImage QImg;
     if (cvImg.channels() == 3) {
 
@@ -161,9 +343,12 @@ QImage WebcamPlayer::convertMatToQImage(Mat cvImg) {
 
         }
     }
+    else if (isBinary) {
+        QImg = BinaryImage::pack(cvImg);
+    }
     else {
         QImg = QImage( const_cast<unsigned char *>(cvImg.data),
-            cvImg.cols, cvImg.rows, cvImg.step, QImage::Format_Indexed8).copy();
+            cvImg.cols, cvImg.rows, cvImg.step, QImage::Format_Grayscale8).copy();
     }
 
     return QImg;
@@ -176,16 +361,14 @@ bool WebcamPlayer::isStopped() const {
 }
 
 /*
- * Release device from video capture, preventing interruption from other threads
+ * Release the frame source, once the player thread no longer uses it
  */
 void WebcamPlayer::release() {
-    mutex.lock();
-    if (capture.isOpened() ) {
-        stop();
-        capture.release();
-    }
+    stop();
+    wait();
 
-    mutex.unlock();
+    // Drop the reference, which closes the source
+    source.release();
 }
 
 /*
@@ -196,81 +379,177 @@ void WebcamPlayer::stop() {
 }
 
 /*
- * Set webcam to run with the best possible resolution (up to 8K UHD)
+ * Stop and close the source to save power (e.g. while a snapshot is shown). Playing again reopens it,
+ * which is quicker than the first time since webcams keep the resolution they were set to
  */
-bool WebcamPlayer::useMaxResolution() {
-    if (!capture.isOpened()) {
-        return false;
+void WebcamPlayer::suspend() {
+    stop();
+    wait();
+
+    if (!source.empty()) {
+        source->release();
+        suspendedSource = source;
+        source.release();
     }
+}
 
-    double initWidth = capture.get(CV_CAP_PROP_FRAME_WIDTH);
-    double initHeight = capture.get(CV_CAP_PROP_FRAME_HEIGHT);
+bool WebcamPlayer::isSuspended() const {
+    return !suspendedSource.empty();
+}
 
-    // Set webcam resolution to hightest <= set value
-    bool isResSet = capture.set(CV_CAP_PROP_FRAME_WIDTH, 7680) & capture.set(CV_CAP_PROP_FRAME_HEIGHT, 4320);
+/*
+ * Whether frames that look the same as the last one shown are skipped (they can't be while measuring latency)
+ */
+void WebcamPlayer::setSkippingUnchanged(bool isSkipping) {
+    skippingUnchanged = isSkipping;
+}
 
-    // Set resolution back to previous resolution
-    if (!isResSet) {
-        capture.set(CV_CAP_PROP_FRAME_WIDTH, initWidth);
-        capture.set(CV_CAP_PROP_FRAME_HEIGHT, initHeight);
-    }
+/*
+ * Time between the frames the view presents (from the display's refresh rate and any frame rate cap).
+ * Frames in between are skipped before being processed. 0 processes every frame
+ */
+void WebcamPlayer::setFrameInterval(qint64 ns) {
+    frameInterval = ns;
+}
 
-    return isResSet;
+/*
+ * Take the latest processed frame, with the times it was read and finished processing at
+ * (see PipelineMetrics::now()). Returns false if there is no new frame since the last one taken
+ */
+bool WebcamPlayer::takeFrame(QImage & image, qint64 & capturedAt, qint64 & processedAt) {
+    return mailbox.take(image, capturedAt, processedAt);
+}
+
+/*
+ * Throw away the frame waiting to be taken (e.g. once live video is no longer shown)
+ */
+void WebcamPlayer::discardFrame() {
+    mailbox.clear();
 }
 
 /*
  * Set brightness (image delta) to a given value -256 < b < 256
  */
 void WebcamPlayer::setBrightness(double b) {
+    settingsMutex.lock();
     if (b > 255)
-        brightness = 255;
+        settings.brightness = 255;
     else if (b < -255)
-        brightness = -255;
+        settings.brightness = -255;
     else
-        brightness = b;
+        settings.brightness = b;
+    settingsMutex.unlock();
 }
 
 /*
  * Set contrast (scaling factor of image) to a given value > 0
  */
 void WebcamPlayer::setContrast(double a) {
+    settingsMutex.lock();
     if (a <= 0) {
-        contrast = 0.001;
+        settings.contrast = 0.001;
     }
     else {
-        contrast = a;
+        settings.contrast = a;
     }
+    settingsMutex.unlock();
 }
 
 /*
  * Set color filter to an identifiable filter
  */
 void WebcamPlayer::setFilter(std::string filter) {
+    settingsMutex.lock();
     if ( filter == "Black and White" || filter == "Greyscale") {
-        this->filter = filter;
+        settings.filter = filter;
     }
     else {
-        this->filter = "None";
+        settings.filter = "None";
     }
+    settingsMutex.unlock();
 }
 
 /*
  * Set angle of rotation for image
  */
 void WebcamPlayer::setRotation(int angle) {
-    this->angle = angle % 360;
+    settingsMutex.lock();
+    settings.angle = angle % 360;
+    settingsMutex.unlock();
+}
+
+/*
+ * Copy of all the settings used to process images
+ */
+ImageSettings WebcamPlayer::getImageSettings() {
+    settingsMutex.lock();
+    ImageSettings curSettings = settings;
+    settingsMutex.unlock();
+
+    return curSettings;
+}
+
+/*
+ * Start (or stop) building a mosaic of the page from frames as it moves under the camera.
+ * Starting always begins a new mosaic
+ */
+void WebcamPlayer::setStitching(bool isStitching) {
+    mutex.lock();
+    if (isStitching && !stitching) {
+        stitchingReset = true;
+    }
+    stitching = isStitching;
+    mutex.unlock();
+}
+
+bool WebcamPlayer::isStitching() {
+    mutex.lock();
+    bool isStitching = stitching;
+    mutex.unlock();
+    return isStitching;
+}
+
+/*
+ * Full resolution image of the stitched page (downscaled if larger than 8K UHD)
+ */
+Mat WebcamPlayer::renderMosaic() {
+    stitcherMutex.lock();
+    Mat mosaic = stitcher.render();
+    stitcherMutex.unlock();
+
+    return mosaic;
+}
+
+/*
+ * Copy of the last unmodified frame that was read. Only call while the player is not running
+ */
+Mat WebcamPlayer::getLastFrame() {
+    return frame.clone();
+}
+
+/*
+ * Settings the last frame shown was processed with, lowered if the governor reduced its quality.
+ * Returns false if no frame was processed since playing. Only call while the player is not running
+ */
+bool WebcamPlayer::getLastFrameSettings(ImageSettings & frameSettings) {
+    if (lastThumbnail.empty()) {
+        return false;
+    }
+
+    frameSettings = lastSettings;
+    return true;
 }
 
 double WebcamPlayer::getContrast() {
-    return contrast;
+    return getImageSettings().contrast;
 }
 
 double WebcamPlayer::getBrightness() {
-    return brightness;
+    return getImageSettings().brightness;
 }
 
 std::string WebcamPlayer::getFilter() {
-    return filter;
+    return getImageSettings().filter;
 }
 
 int WebcamPlayer::getWebcam() {
@@ -278,12 +557,10 @@ int WebcamPlayer::getWebcam() {
 }
 
 int WebcamPlayer::getRotation() {
-    return angle;
+    return getImageSettings().angle;
 }
 
 WebcamPlayer::~WebcamPlayer() {
-    release();
-
     // Stop running thread
-    wait();
+    release();
 }
@@ -5,6 +5,8 @@
 #include <QThread>
 
 // Implementation classes
+#include <algorithm>
+#include <atomic>
 #include <string>
 
 #include <QImage>
@@ -14,42 +16,100 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 
+#include "binaryimage.h"
+#include "camerasource.h"
+#include "captureopener.h"
+#include "framemailbox.h"
+#include "imagepipeline.h"
+#include "imagesettings.h"
+#include "pagestitcher.h"
+#include "pipelinemetrics.h"
+#include "qualitygovernor.h"
+#include "tracer.h"
+
 using namespace cv;
 
 /*
- * Captures video from a webcam and sends frame data as a QImage
+ * Captures video from a webcam (or another frame source) and sends frame data as a QImage
  */
 class WebcamPlayer : public QThread {
     Q_OBJECT
 
 private:
     int curWebcam = 0;
-    int angle = 0;
     bool stopped;
     QMutex mutex;
+    QMutex settingsMutex;
+    QMutex stitcherMutex;
     Mat frame;
     QImage processedImage;
-    QImage rawImage;
 
-    VideoCapture capture;
+    // Source being played (only used by the player thread), and the next source being opened
+    Ptr<FrameSource> source;
+    CaptureOpener * opener;
+    // Source closed to save power, reopened when playing again
+    Ptr<FrameSource> suspendedSource;
+    // Source to open next, once the player has released the one it plays if both are on the same device
+    Ptr<FrameSource> requestedSource;
+
+    PipelineMetrics * metrics;
+    // Lowers the quality of video frames when processing falls behind the source
+    QualityGovernor governor;
+
+    // Latest processed frame, waiting for the view to present it
+    FrameMailbox mailbox;
+    // Time between frames the view presents (0 to process every frame), and when the next one is due
+    std::atomic<qint64> frameInterval{0};
+    qint64 nextFrameDue = 0;
+
+    // Thumbnail & settings of the last frame processed, to skip frames while the page is still
+    std::atomic<bool> skippingUnchanged{true};
+    Mat lastThumbnail;
+    ImageSettings lastSettings;
 
-    double contrast; // "Alpha" value as scaling factor (multiplication)
-    double brightness; // "Beta" value as image delta (addition)
-    std::string filter; // Image filter to be applied
+    ImageSettings settings;
+
+    bool stitching = false; // Whether frames are added to the mosaic instead of being shown directly
+    bool stitchingReset = false; // Whether the mosaic should be cleared before the next frame
+    PageStitcher stitcher;
+
+    bool openRequestedSource();
+    bool switchSource();
+    bool isFrameDue(qint64 capturedAt);
+    void postFrame(qint64 capturedAt, qint64 processedAt);
+    static Mat makeThumbnail(const Mat & img);
+    static bool isThumbnailChanged(const Mat & thumbnail, const Mat & lastThumbnail);
 
 protected:
     void run();
 
 public:
+    // Time to wait for the first source to open before checking whether the player was stopped
+    static const int OPEN_WAIT_MS = 100;
+    // Size of the thumbnails compared to detect a still page
+    static const int THUMBNAIL_WIDTH = 64;
+    static const int THUMBNAIL_HEIGHT = 48;
+    // Change in a thumbnail pixel (or on average) that counts as the page moving, above webcam noise
+    static const int MAX_PIXEL_CHANGE = 12;
+    static constexpr double MAX_MEAN_CHANGE = 2;
+    // Frame rate assumed for sources that don't report one
+    static constexpr double DEFAULT_SOURCE_FPS = 30;
+
     WebcamPlayer(QObject * parent = nullptr);
     ~WebcamPlayer();
 
-    bool open(int device = 0);
+    void open(int device = 0);
+    void open(Ptr<FrameSource> newSource);
     void release();
     void play();
     void stop();
+    void suspend();
+    bool isSuspended() const;
     bool isStopped() const;
-    bool useMaxResolution();
+    void setSkippingUnchanged(bool isSkipping);
+    void setFrameInterval(qint64 ns);
+    bool takeFrame(QImage & image, qint64 & capturedAt, qint64 & processedAt);
+    void discardFrame();
     void setBrightness(double b);
     void setContrast(double a);
     void setFilter(std::string filter);
@@ -59,13 +119,20 @@ public:
     std::string getFilter();
     int getWebcam();
     int getRotation();
+    void setStitching(bool isStitching);
+    bool isStitching();
+    Mat renderMosaic();
+    Mat getLastFrame();
+    bool getLastFrameSettings(ImageSettings & frameSettings);
+    ImageSettings getImageSettings();
     Mat processImage(Mat img);
-    Mat convertQImageToMat(QImage QImg);
-    QImage convertMatToQImage(Mat cvImg);
+    static Mat processImage(Mat img, const ImageSettings & settings);
+    static Mat convertQImageToMat(QImage QImg);
+    static QImage convertMatToQImage(Mat cvImg, bool isBinary = false);
 
 signals:
-    void imageRead(const QImage & image);
-    void imageProcessed(const QImage & image);
+    // A processed frame is waiting in the mailbox (see takeFrame())
+    void frameReady();
     void readError();
 };
 
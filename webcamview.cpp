@@ -1,50 +1,36 @@
 #include "webcamview.h"
 
-WebcamView::WebcamView(QWidget * parent)
+WebcamView::WebcamView(QWidget * parent, cv::Ptr<FrameSource> source)
     : QGraphicsView(parent)
 {
-    QSettings settings(QSettings::NativeFormat, QSettings::UserScope, "JDWhite", "MagniRead");
-    int device = (settings.contains("webcam/deviceIndex"))
-                  ? settings.value("webcam/deviceIndex").toInt()
-                  : DEFAULT_DEVICE;
+    // Guiding line is hidden unless enabled
+    guidingLine.setVisible(false);
 
-    if (settings.contains("controls/clickToDrag")) {
-        setClickToDragEnabled( settings.value("controls/clickToDrag").toBool() );
-    }
-
-    if (settings.contains("controls/isLineDrawn")) {
-        setGuidingLineEnabled( settings.value("controls/isLineDrawn").toBool() );
-    }
-
-    if (settings.contains("controls/linePos")) {
-        // Change percentage to fraction of position down the screen
-        setGuidingLinePos( settings.value("controls/linePos").toDouble() / 100 );
-    }
+    SettingsModel * model = SettingsModel::instance();
+    int device = model->getDeviceIndex();
 
-    if (settings.contains("controls/lineThickness")) {
-        setGuidingLineThickness( settings.value("controls/lineThickness").toInt() );
-    }
+    setClickToDragEnabled( model->isClickToDrag() );
+    setGuidingLineEnabled( model->isLineDrawn() );
+    // Change percentage to fraction of position down the screen
+    setGuidingLinePos( double(model->getLinePos()) / 100 );
+    setGuidingLineThickness( model->getLineThickness() );
+    setGuidingLineColor( model->getLineColor() );
+    maxFps = model->getMaxFps();
 
-    if (settings.contains("controls/lineColor")) {
-        QColor color = QColor( settings.value("controls/lineColor").toString() );
-        if (color.isValid()) {
-            setGuidingLineColor(color);
-        }
-    }
-
-    init(DEFAULT_MODE, device, parent);
+    init(DEFAULT_MODE, device, parent, source);
 }
 
 WebcamView::WebcamView(int device, QWidget * parent)
     : QGraphicsView(parent)
 {
+    guidingLine.setVisible(false);
     init(DEFAULT_MODE, device, parent);
 }
 
 /*
- * Initialization of WebcamView
+ * Initialization of WebcamView. A frame source given instead of the webcam means the webcam is never opened
  */
-void WebcamView::init(WebcamView::Mode mode, int device, QWidget * parent) {
+void WebcamView::init(WebcamView::Mode mode, int device, QWidget * parent, cv::Ptr<FrameSource> source) {
     this->mode = mode;
 
     // Change viewport functionality & appearance
@@ -55,8 +41,8 @@ void WebcamView::init(WebcamView::Mode mode, int device, QWidget * parent) {
     setAlignment(Qt::AlignTop | Qt::AlignLeft);
     // To zoom from center of the image
     setTransformationAnchor(QGraphicsView::AnchorViewCenter);
-    // To fully update everything that is drawn in paint event
-    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    // To only repaint regions that changed (overlays are cached items, so they are cheap to redraw)
+    setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
     // To always track mouse, not just when clicking
     this->setMouseTracking(true);
 
@@ -64,15 +50,63 @@ void WebcamView::init(WebcamView::Mode mode, int device, QWidget * parent) {
     scene = new QGraphicsScene(parent);
     setScene(scene);
 
-    // Setup video capture and load video
+    // Snapshots are drawn from tiles once they are ready (enough cache to hold the tiles of a few screens)
+    QPixmapCache::setCacheLimit(qMax(QPixmapCache::cacheLimit(), 128 * 1024));
+    tiledItem.setVisible(false);
+    scene->addItem(&tiledItem);
+    addOverlay(&guidingLine);
+    addOverlay(&statusMessage);
+    statsOverlay.setVisible(false);
+    addOverlay(&statsOverlay);
+    addOverlay(&calibrationPatch);
+    calibrator = new LatencyCalibrator(&calibrationPatch, this);
+    connect(calibrator, SIGNAL (finished(bool, double)), this, SLOT (showLatencyCalibration(bool, double)));
+    statsTimer.setInterval(STATS_INTERVAL_MS);
+    connect(&statsTimer, SIGNAL (timeout()), this, SLOT (updateStats()));
+    suspendTimer.setSingleShot(true);
+    suspendTimer.setInterval(SUSPEND_DELAY_MS);
+    connect(&suspendTimer, SIGNAL (timeout()), this, SLOT (suspendVideo()));
+    pyramidBuilder = new PyramidBuilder(this);
+    snapshotProcessor = new SnapshotProcessor(this);
+    connect(snapshotProcessor, SIGNAL (previewProcessed(QImage, double, int)),
+            this, SLOT (showSnapshotPreview(QImage, double, int)), Qt::QueuedConnection);
+    connect(snapshotProcessor, SIGNAL (snapshotProcessed(QImage, int)),
+            this, SLOT (showProcessedSnapshot(QImage, int)), Qt::QueuedConnection);
+    connect(pyramidBuilder, SIGNAL (pyramidBuilt()),
+            this, SLOT (showPyramid()), Qt::QueuedConnection);
+    history = new SnapshotHistory(this);
+    connect(history, SIGNAL (snapshotLoaded()),
+            this, SLOT (showHistorySnapshot()), Qt::QueuedConnection);
+
+    // Resample in high quality after interaction stops, above the image that is drawn quickly
+    refinedItem.setVisible(false);
+    refinedItem.setZValue(1);
+    refinedItem.setFlag(QGraphicsItem::ItemIgnoresTransformations);
+    scene->addItem(&refinedItem);
+    imageRefiner = new ImageRefiner(this);
+    refineTimer.setSingleShot(true);
+    refineTimer.setInterval(REFINE_DELAY_MS);
+    connect(&refineTimer, SIGNAL (timeout()),
+            this, SLOT (refineVisibleRegion()));
+    connect(imageRefiner, SIGNAL (refined()),
+            this, SLOT (showRefinedImage()), Qt::QueuedConnection);
+
+    // Setup video capture and load video (the device is opened in the background, so the window shows up first)
     videoPlayer = new WebcamPlayer(this);
-    openWebcam(device);
-    connect(videoPlayer, SIGNAL (imageRead(QImage)),
-            this, SLOT (setSnapshotImage(QImage)));
-    connect(videoPlayer, SIGNAL (imageProcessed(QImage)),
-            this, SLOT (updateImage(QImage)));
+    connect(videoPlayer, SIGNAL (frameReady()),
+            this, SLOT (presentFrame()));
     connect(videoPlayer, SIGNAL (readError()),
             this, SLOT (handleError()));
+    presentTimer.setSingleShot(true);
+    presentTimer.setTimerType(Qt::PreciseTimer);
+    connect(&presentTimer, SIGNAL (timeout()), this, SLOT (presentFrame()));
+    updateFramePacing();
+    if (source.empty()) {
+        openWebcam(device);
+    }
+    else {
+        openSource(source);
+    }
 
     // Initial display
     if (mode == SNAPSHOT) {
@@ -83,7 +117,6 @@ void WebcamView::init(WebcamView::Mode mode, int device, QWidget * parent) {
         videoPlayer->play();
     }
     else if (mode == ERROR ) {
-        // TODO: "Webcam not found" image shown on screen
         handleError();
     }
 
@@ -92,70 +125,533 @@ void WebcamView::init(WebcamView::Mode mode, int device, QWidget * parent) {
 }
 
 /*
- * Rescale image so that it keeps the aspect ratio, fills the entire viewport, and scrolls properly
+ * Show the latest frame from the player, unless the next display refresh isn't due yet (then the frame
+ * is shown at the refresh, or replaced by a newer one before it)
  */
-void WebcamView::updateImage(QImage img) {
+void WebcamView::presentFrame() {
+    // Frames still queued from before the video stopped mustn't replace a snapshot
+    if (mode != PREVIEW && mode != PANORAMA) {
+        return;
+    }
+
+    qint64 now = PipelineMetrics::now();
+    qint64 due = lastPresentTime + presentInterval;
+    if (now + PRESENT_SLACK_NS < due) {
+        if (!presentTimer.isActive()) {
+            presentTimer.start( int((due - now + 999999) / 1000000) );
+        }
+        return;
+    }
+
+    QImage img;
+    qint64 capturedAt;
+    qint64 processedAt;
+    if (!videoPlayer->takeFrame(img, capturedAt, processedAt)) {
+        return;
+    }
+
+    // Stay in step with the refresh rather than drifting with late timers, unless frames stopped for a while
+    lastPresentTime = (now - due < presentInterval) ? due : now;
+    updateImage(img, capturedAt, processedAt);
+}
+
+/*
+ * Present frames at the refresh rate of the screen the view is on, or the frame rate cap if it's lower.
+ * Widgets can't wait for the display's vertical sync, so frames are presented on a precise timer instead
+ */
+void WebcamView::updateFramePacing() {
+    QWindow * windowHandle = window()->windowHandle();
+    QScreen * screen = (windowHandle != nullptr) ? windowHandle->screen() : QGuiApplication::primaryScreen();
+    double refreshRate = (screen != nullptr && screen->refreshRate() > 0) ? screen->refreshRate() : DEFAULT_REFRESH_RATE;
+    double fps = (maxFps > 0) ? qMin(refreshRate, double(maxFps)) : refreshRate;
+
+    presentInterval = qint64(1e9 / fps);
+    videoPlayer->setFrameInterval(presentInterval);
+}
+
+/*
+ * Limit the frame rate of live video (0 to follow the display's refresh rate)
+ */
+void WebcamView::setMaxFps(int fps) {
+    maxFps = qMax(0, fps);
+    updateFramePacing();
+}
+
+/*
+ * Show new image at its native resolution, rescaling the view if the image size changed.
+ * Video frames give the times they were read and processed at, to measure how long they take to be shown
+ */
+void WebcamView::updateImage(QImage img, qint64 capturedAt, qint64 processedAt) {
+    TRACE_SCOPE("updateImage");
+
+    PipelineMetrics * metrics = PipelineMetrics::instance();
+    qint64 uploadStart = PipelineMetrics::now();
+    if (processedAt > 0) {
+        metrics->record(PipelineMetrics::QUEUE_WAIT, uploadStart - processedAt);
+        Tracer::record("Frame delivery", processedAt, uploadStart);
+        if (isFramePending) {
+            metrics->countFrameDropped();
+        }
+        isFramePending = true;
+        pendingCaptureTime = capturedAt;
+
+        if (calibrator->isActive()) {
+            calibrator->frameReceived(img);
+        }
+    }
 
     // Replace old image
     image = img;
+    statusMessage.setVisible(false);
 
-    // Rescale new image so that it at least fills the viewport
-    QPixmap pixmap = QPixmap::fromImage(img).scaled(
-                static_cast<int>(this->size().width()),
-                static_cast<int>(this->size().height()),
-                Qt::KeepAspectRatioByExpanding, Qt::FastTransformation );
+    QSize oldSize = imageItem.getSize();
+    imageItem.setImage(img);
+    if (processedAt > 0) {
+        metrics->record(PipelineMetrics::UPLOAD, PipelineMetrics::now() - uploadStart);
+    }
 
-    // Create painter for pixmap (unused, but guiding line jitters less when paintEvent called)
-    QPainter painter(&pixmap);
+    if (imageItem.scene() == nullptr) {
+        scene->addItem(&imageItem);
+    }
 
-    imageItem.setPixmap(pixmap);
+    if (imageItem.getSize() != oldSize) {
+        scene->setSceneRect(imageItem.boundingRect());
+        updateTransform();
+    }
 
-    if (scene->items().count() == 0) {
-        scene->addItem(&imageItem);
+    // Snapshots are split into tiles in the background, video frames are always drawn directly
+    if (mode == SNAPSHOT) {
+        buildPyramid(img);
+        restartRefinement();
+    }
+    else if (tiledItem.isVisible()) {
+        pyramidBuilder->cancel();
+        setTiledImageVisible(false);
     }
 
-    // Prepare rescaled view for display
-    this->show();
+    if (!isFirstFrameShown) {
+        isFirstFrameShown = true;
+        emit firstFrameShown();
+    }
+}
+
+/*
+ * Split an image into tiles in the background. Tiles of a different image are hidden straight away,
+ * so that the image is drawn directly until its own tiles are ready
+ */
+void WebcamView::buildPyramid(const QImage & img) {
+    QSharedPointer<TilePyramid> pyramid = tiledItem.getPyramid();
+    if (pyramid.isNull() || pyramid->getSourceKey() != img.cacheKey()) {
+        pyramidBuilder->cancel();
+        setTiledImageVisible(false);
+    }
+
+    pyramidBuilder->build(img);
+}
+
+/*
+ * Replace the full image with its tiles once they are built for the image that is still displayed
+ */
+void WebcamView::showPyramid() {
+    QSharedPointer<TilePyramid> pyramid = pyramidBuilder->takePyramid();
+    if (pyramid.isNull() || mode != SNAPSHOT || pyramid->getSourceKey() != image.cacheKey()) {
+        return;
+    }
+
+    tiledItem.setPyramid(pyramid);
+    setTiledImageVisible(true);
 }
 
-void WebcamView::setSnapshotImage(const QImage & img) {
-    snapshotImage = img;
+/*
+ * Hide high quality image (it no longer matches the view) and wait for interaction to stop before making a new one
+ */
+void WebcamView::restartRefinement() {
+    refineRequest++;
+    refinedItem.setVisible(false);
+
+    if (mode == SNAPSHOT) {
+        refineTimer.start();
+    }
+    else {
+        refineTimer.stop();
+    }
 }
 
 /*
- * Manually process snapshot image and update viewport to show processed image
+ * Request a high quality resample of the part of the snapshot that is visible, at screen resolution
+ */
+void WebcamView::refineVisibleRegion() {
+    if (mode != SNAPSHOT || image.isNull()) {
+        return;
+    }
+
+    double scale = transform().m11();
+    QRect region = mapToScene(viewport()->rect()).boundingRect().toAlignedRect() & image.rect();
+    QSize targetSize(qRound(region.width() * scale), qRound(region.height() * scale));
+
+    // Nothing to gain when drawn at the image's own resolution
+    if (region.isEmpty() || targetSize == region.size()) {
+        return;
+    }
+
+    imageRefiner->refine(image, region, targetSize, refineRequest);
+}
+
+/*
+ * Show the high quality image over the visible region, if the view hasn't changed since it was requested
+ */
+void WebcamView::showRefinedImage() {
+    QImage refined;
+    QRect region;
+    int requestId;
+    if (!imageRefiner->takeResult(refined, region, requestId) || requestId != refineRequest || mode != SNAPSHOT) {
+        return;
+    }
+
+    refinedItem.setPixmap(QPixmap::fromImage(refined));
+    refinedItem.setPos(region.topLeft());
+    refinedItem.setVisible(true);
+}
+
+void WebcamView::setTiledImageVisible(bool isVisible) {
+    tiledItem.setVisible(isVisible);
+    imageItem.setVisible(!isVisible);
+}
+
+/*
+ * Scale view so that the image keeps its aspect ratio and at least fills the viewport, then apply zoom
+ */
+void WebcamView::updateTransform() {
+    QSize imageSize = imageItem.getSize();
+    if (imageSize.isEmpty()) {
+        return;
+    }
+
+    double fitScale = qMax(double(viewport()->width()) / imageSize.width(),
+                           double(viewport()->height()) / imageSize.height());
+    double scale = fitScale * zoomFactor;
+
+    setTransform(QTransform::fromScale(scale, scale));
+    if (isCenterRestored) {
+        centerOn(restoredCenter);
+    }
+    updateOverlays();
+    restartRefinement();
+}
+
+/*
+ * Set unmodified image that is processed while in snapshot mode
+ */
+void WebcamView::setSnapshotImage(const cv::Mat & img) {
+    snapshotSource = img;
+    hasSnapshot = !img.empty();
+    isSnapshotProcessed = false;
+    snapshotProcessor->setSnapshot(img);
+}
+
+/*
+ * Process snapshot image in the background. The viewport shows a quick preview, then the full processed image
  */
 void WebcamView::processSnapshotImage() {
-    QImage processedImage;
+    ImageSettings settings = videoPlayer->getImageSettings();
+
+    // Nothing to do if only other settings (e.g. the guiding line) changed
+    if (!hasSnapshot || (isSnapshotProcessed && settings == snapshotSettings)) {
+        return;
+    }
+
+    // Snapshot restored from a file is only read once it has to be processed again
+    if (snapshotSource.empty() && !sessionFile.isNull()) {
+        setSnapshotImage(sessionFile->readSource());
+    }
+
+    snapshotSettings = settings;
+    isSnapshotProcessed = true;
+    snapshotRequest = snapshotProcessor->process(settings);
+}
+
+/*
+ * Show downscaled preview of the processed snapshot, stretched to the size of the full image
+ */
+void WebcamView::showSnapshotPreview(const QImage & preview, double previewScale, int requestId) {
+    if (requestId != snapshotRequest || mode != SNAPSHOT) {
+        return;
+    }
+
+    // Tiles of the previous snapshot are outdated
+    pyramidBuilder->cancel();
+    setTiledImageVisible(false);
+
+    QSize oldSize = imageItem.getSize();
+    QSize fullSize(qRound(preview.width() / previewScale), qRound(preview.height() / previewScale));
+    imageItem.setImage(preview, fullSize);
+
+    if (imageItem.getSize() != oldSize) {
+        scene->setSceneRect(imageItem.boundingRect());
+        updateTransform();
+    }
+
+    restartRefinement();
+}
+
+/*
+ * Show processed snapshot at full resolution, if it is from the latest request
+ */
+void WebcamView::showProcessedSnapshot(const QImage & img, int requestId) {
+    if (requestId != snapshotRequest || mode != SNAPSHOT) {
+        return;
+    }
+
+    // Tiles are no longer drawn from the restored file
+    sessionFile.clear();
+    isSnapshotShown = true;
+    shownSettings = snapshotSettings;
+    updateImage(img);
+}
+
+/*
+ * Show a snapshot from the history again (once it's decompressed), processed with the current settings
+ */
+void WebcamView::showSnapshot(int id) {
+    historyRequest = id;
+    history->load(id);
+}
 
-    if (!snapshotImage.isNull()) {
-        cv::Mat cvImage = videoPlayer->convertQImageToMat(snapshotImage);
-        cvImage = videoPlayer->processImage(cvImage);
-        processedImage = videoPlayer->convertMatToQImage(cvImage);
-        updateImage(processedImage);
+/*
+ * Switch to the snapshot from the history, if it's the one that was chosen last
+ */
+void WebcamView::showHistorySnapshot() {
+    int id;
+    cv::Mat snapshot;
+    if (!history->takeLoaded(id, snapshot) || id != historyRequest || snapshot.empty()) {
+        return;
     }
+
+    restoredSnapshot = snapshot;
+    setMode(SNAPSHOT);
+}
+
+/*
+ * Snapshots taken so far (see SnapshotGallery)
+ */
+SnapshotHistory * WebcamView::getHistory() {
+    return history;
+}
+
+/*
+ * Add new snapshots as pages of the document, until it's replaced or set to null
+ */
+void WebcamView::setDocument(DocumentWriter * document) {
+    this->document = document;
+}
+
+/*
+ * Keep a new snapshot in the history, and in the document being made (with the settings it's shown with)
+ */
+void WebcamView::keepSnapshot(const cv::Mat & snapshot) {
+    history->add(snapshot);
+    if (document != nullptr) {
+        document->addPage(snapshot, videoPlayer->getImageSettings());
+    }
+}
+
+/*
+ * Show the snapshot saved in a session file, drawn straight from the file's tiles. Returns false if there is none
+ */
+bool WebcamView::restoreSession(const QString & path) {
+    TRACE_SCOPE("Restore session");
+
+    QSharedPointer<SnapshotFile> file = SnapshotFile::open(path);
+    if (file.isNull()) {
+        return false;
+    }
+
+    sessionFile = file;
+    setMode(SNAPSHOT);
+    return true;
+}
+
+/*
+ * Save the snapshot on screen with its settings & view, so that it's shown again next time. A snapshot that
+ * is still shown from the session file only has its view updated. Without a snapshot, the file is removed
+ */
+bool WebcamView::saveSession(const QString & path) {
+    TRACE_SCOPE("Save session");
+
+    QPointF center = mapToScene(viewport()->rect().center());
+    if (mode == SNAPSHOT && !sessionFile.isNull()) {
+        sessionFile->setView(zoomFactor, center);
+        return true;
+    }
+
+    bool isSaved = (mode == SNAPSHOT && isSnapshotShown && !image.isNull() && !snapshotSource.empty());
+    QSharedPointer<TilePyramid> pyramid = tiledItem.getPyramid();
+    if (isSaved && (pyramid.isNull() || pyramid->getSourceKey() != image.cacheKey())) {
+        // Tiles weren't built in the background yet
+        pyramid.reset(new TilePyramid(image.cacheKey()));
+        QImage level = TilePyramid::normalizeFormat(image);
+        forever {
+            pyramid->addLevel(level);
+            if (level.width() <= TilePyramid::TILE_SIZE && level.height() <= TilePyramid::TILE_SIZE) {
+                break;
+            }
+            level = TilePyramid::downsample(level);
+        }
+    }
+
+    // Tiles drawn from an older file keep it mapped, which stops it being replaced on some systems
+    tiledItem.setPyramid(QSharedPointer<TilePyramid>());
+
+    if (!isSaved) {
+        QFile::remove(path);
+        return false;
+    }
+
+    return SnapshotFile::write(path, *pyramid, snapshotSource, shownSettings, zoomFactor, center);
+}
+
+/*
+ * Show a restored snapshot from the tiles of its file (nothing is decoded), at its saved zoom & centre
+ */
+void WebcamView::showSessionFile(QSharedPointer<SnapshotFile> file) {
+    QSharedPointer<TilePyramid> pyramid = file->getPyramid();
+
+    sessionFile = file;
+    snapshotSource.release();
+    hasSnapshot = true;
+    isSnapshotProcessed = true;
+    snapshotSettings = file->getSettings();
+    isSnapshotShown = true;
+    shownSettings = snapshotSettings;
+
+    // Smallest level stands in for the image until tiles are drawn
+    pyramidBuilder->cancel();
+    image = QImage();
+    const TilePyramid::Level & smallest = pyramid->getLevel(pyramid->getLevelCount() - 1);
+    imageItem.setImage(smallest.tiles.first(), pyramid->getSize());
+    if (imageItem.scene() == nullptr) {
+        scene->addItem(&imageItem);
+    }
+    scene->setSceneRect(imageItem.boundingRect());
+
+    tiledItem.setPyramid(pyramid);
+    setTiledImageVisible(true);
+    statusMessage.setVisible(false);
+
+    zoomFactor = file->getZoom();
+    restoredCenter = file->getCenter();
+    isCenterRestored = true;
+    updateTransform();
+
+    if (!isFirstFrameShown) {
+        isFirstFrameShown = true;
+        emit firstFrameShown();
+    }
+
+    // Processed again if the settings changed since it was saved
+    processSnapshotImage();
+}
+
+double WebcamView::getZoom() {
+    return zoomFactor;
 }
 
 /*
  * Resize current image to fit the screen
  */
 void WebcamView::resize() {
-    if (!image.isNull()) {
-        updateImage(image);
-    }
+    updateTransform();
+}
+
+/*
+ * Zoom in image by a factor of the size that fits the screen
+ */
+void WebcamView::setZoom(double zoomFactor) {
+    this->zoomFactor = zoomFactor;
+    updateTransform();
 }
 
 /*
  * Change what is being viewed
  */
 void WebcamView::setMode(WebcamView::Mode mode) {
+    Mode oldMode = this->mode;
     this->mode = mode;
 
+    // Restored snapshot is only shown from its file until another one is shown
+    QSharedPointer<SnapshotFile> file = sessionFile;
+    sessionFile.clear();
+    isSnapshotShown = false;
+    isCenterRestored = false;
+
+    restartRefinement();
+
+    // Measuring latency needs the live video
+    if (mode != PREVIEW) {
+        calibrator->cancel();
+    }
+
     if (mode == PREVIEW) {
+        suspendTimer.stop();
+        videoPlayer->setStitching(false);
         videoPlayer->play();
     }
     else if (mode == SNAPSHOT) {
         videoPlayer->stop();
+        videoPlayer->wait();
+        videoPlayer->setStitching(false);
+        presentTimer.stop();
+        videoPlayer->discardFrame();
+        suspendTimer.start();
+
+        // Snapshot chosen from the history is shown instead of taking a new one
+        if (!restoredSnapshot.empty()) {
+            setSnapshotImage(restoredSnapshot);
+            restoredSnapshot.release();
+            processSnapshotImage();
+        }
+        // Snapshot saved when the app last closed
+        else if (!file.isNull()) {
+            showSessionFile(file);
+        }
+        // Stitched page becomes the snapshot once the last frame has been added
+        else if (oldMode == PANORAMA) {
+            cv::Mat mosaic = videoPlayer->renderMosaic();
+            if (!mosaic.empty()) {
+                setSnapshotImage(mosaic);
+                keepSnapshot(mosaic);
+                processSnapshotImage();
+            }
+        }
+        else {
+            cv::Mat frame = videoPlayer->getLastFrame();
+            setSnapshotImage(frame);
+            keepSnapshot(frame);
+
+            // Last frame shown is reused only if it was processed at full quality with the current settings
+            ImageSettings frameSettings;
+            bool isFrameReused = !image.isNull() && videoPlayer->getLastFrameSettings(frameSettings)
+                    && frameSettings == videoPlayer->getImageSettings();
+            if (isFrameReused) {
+                snapshotSettings = frameSettings;
+                isSnapshotProcessed = true;
+                isSnapshotShown = true;
+                shownSettings = snapshotSettings;
+                // Live frames aren't packed, but snapshots are
+                if (snapshotSettings.isBinary()) {
+                    image = WebcamPlayer::convertMatToQImage(WebcamPlayer::convertQImageToMat(image), true);
+                }
+                buildPyramid(image);
+            }
+            else {
+                processSnapshotImage();
+            }
+        }
+    }
+    else if (mode == PANORAMA) {
+        suspendTimer.stop();
+        videoPlayer->setStitching(true);
+        videoPlayer->play();
     }
 
     emit modeChanged();
@@ -233,11 +729,11 @@ bool WebcamView::isDragging() {
 }
 
 void WebcamView::setGuidingLineEnabled(bool guidingLineEnabled) {
-    this->guidingLineEnabled = guidingLineEnabled;
+    guidingLine.setVisible(guidingLineEnabled);
 }
 
 void WebcamView::setGuidingLineColor(QColor color) {
-    this->guidingLineColor = color;
+    guidingLine.setColor(color);
 }
 
 /*
@@ -251,7 +747,8 @@ void WebcamView::setGuidingLinePos(double percent) {
         percent = 1;
     }
 
-    this->guidingLinePos = 1-percent;
+    guidingLine.setLinePos(1-percent);
+    updateOverlays();
 }
 
 void WebcamView::setGuidingLineThickness(int px) {
@@ -259,11 +756,108 @@ void WebcamView::setGuidingLineThickness(int px) {
         px = 1;
     }
 
-    this->guidingLineThickness = px;
+    guidingLine.setThickness(px);
 }
 
 bool WebcamView::isGuidingLineEnabled() {
-    return guidingLineEnabled;
+    return guidingLine.isVisible();
+}
+
+/*
+ * Show frame rate, dropped frames, and the median & 99th percentile time of each stage of showing a frame,
+ * over the last STATS_INTERVAL_MS (shown once the first interval has passed)
+ */
+void WebcamView::setStatsVisible(bool isVisible) {
+    statsOverlay.setVisible(isVisible);
+    if (isVisible) {
+        // Times recorded while the statistics were hidden are left out
+        PipelineMetrics::instance()->startWindow();
+        lastFramesShown = PipelineMetrics::instance()->getFramesShown();
+        lastStatsTime = PipelineMetrics::now();
+        statsOverlay.setLines(QStringList() << "Measuring...");
+        statsTimer.start();
+    }
+    else {
+        statsTimer.stop();
+    }
+}
+
+/*
+ * Measure the delay from the screen to the webcam and back (the webcam must be pointed at the screen)
+ */
+void WebcamView::startLatencyCalibration() {
+    if (mode == PREVIEW && !calibrator->isActive()) {
+        // Every frame is needed, even while the screen stays the same
+        videoPlayer->setSkippingUnchanged(false);
+        calibrator->start();
+    }
+}
+
+/*
+ * Report the measured delay, which is added to the statistics
+ */
+void WebcamView::showLatencyCalibration(bool isMeasured, double medianMs) {
+    videoPlayer->setSkippingUnchanged(true);
+
+    if (isMeasured) {
+        qInfo("Glass to glass latency: %.1f ms (median)", medianMs);
+        setStatsVisible(true);
+    }
+    else {
+        qWarning("Glass to glass latency could not be measured: point the webcam at the screen");
+    }
+}
+
+bool WebcamView::isStatsVisible() {
+    return statsOverlay.isVisible();
+}
+
+void WebcamView::updateStats() {
+    PipelineMetrics * metrics = PipelineMetrics::instance();
+
+    // Frame rate & stage times since the last update
+    metrics->startWindow();
+    qint64 time = PipelineMetrics::now();
+    quint64 framesShown = metrics->getFramesShown();
+    double fps = (time > lastStatsTime) ? (framesShown - lastFramesShown) * 1e9 / (time - lastStatsTime) : 0;
+    lastFramesShown = framesShown;
+    lastStatsTime = time;
+
+    QStringList lines;
+    lines << QString("%1 fps, %2 dropped, %3 skipped, %4 unchanged").arg(fps, 0, 'f', 1).arg(metrics->getFramesDropped())
+             .arg(metrics->getFramesSkipped()).arg(metrics->getFramesUnchanged());
+    lines << QString("Quality: %1").arg(QualityGovernor::getLevelName(QualityGovernor::Level(metrics->getQualityLevel())));
+    lines << QString("%1%2%3  (last %4 s)").arg("Stage", -14).arg("p50 (ms)", 10).arg("p99 (ms)", 10)
+             .arg(STATS_INTERVAL_MS / 1000.0, 0, 'f', 1);
+    for (int i = 0; i < PipelineMetrics::STAGE_COUNT; i++) {
+        PipelineMetrics::Stage stage = PipelineMetrics::Stage(i);
+        const LatencyHistogram & histogram = metrics->getHistogram(stage);
+        lines << QString("%1%2%3")
+                 .arg(PipelineMetrics::getStageName(stage), -14)
+                 .arg(histogram.getPercentile(50) / 1000.0, 10, 'f', 2)
+                 .arg(histogram.getPercentile(99) / 1000.0, 10, 'f', 2);
+    }
+
+    statsOverlay.setLines(lines);
+}
+
+/*
+ * Show item over the image at a fixed position of the viewport
+ */
+void WebcamView::addOverlay(OverlayItem * overlay) {
+    overlays.append(overlay);
+    scene->addItem(overlay);
+    updateOverlays();
+}
+
+/*
+ * Keep overlays at their viewport positions after the view is zoomed, dragged, or resized
+ */
+void WebcamView::updateOverlays() {
+    for (OverlayItem * overlay : overlays) {
+        overlay->setViewportSize(viewport()->size());
+        overlay->setPos(mapToScene(overlay->getViewportPos().toPoint()));
+    }
 }
 
 /*
@@ -272,6 +866,9 @@ bool WebcamView::isGuidingLineEnabled() {
 void WebcamView::handleError() {
     setMode(ERROR);
     videoPlayer->stop();
+
+    statusMessage.setText(ERROR_MESSAGE);
+    statusMessage.setVisible(true);
 }
 
 /*
@@ -280,6 +877,9 @@ void WebcamView::handleError() {
 void WebcamView::mousePressEvent(QMouseEvent * event) {
     QGraphicsView::mousePressEvent(event);
 
+    // Restored centre no longer applies once the view is moved
+    isCenterRestored = false;
+
     if (!isClickToDrag) {
         return;
     }
@@ -323,6 +923,8 @@ void WebcamView::mouseMoveEvent(QMouseEvent * event) {
 
         // Reset transformation anchor
         setTransformationAnchor(anchor);
+        updateOverlays();
+        restartRefinement();
 
         mouseOriginX = event->x();
         mouseOriginY = event->y();
@@ -342,47 +944,150 @@ void WebcamView::leaveEvent(QEvent * event) {
 }
 
 /*
- * Draw dotted line across viewport to guide reading
+ * Lay out overlays for the new viewport size
  */
-void WebcamView::paintEvent(QPaintEvent * event) {
+void WebcamView::resizeEvent(QResizeEvent * event) {
+    QGraphicsView::resizeEvent(event);
 
+    updateOverlays();
+}
+
+/*
+ * Time painting, and count the video frame as shown once it is painted
+ */
+void WebcamView::paintEvent(QPaintEvent * event) {
+    TRACE_SCOPE("paintEvent");
+    qint64 paintStart = PipelineMetrics::now();
     QGraphicsView::paintEvent(event);
 
-    if (guidingLineEnabled) {
-        QPainter painter(viewport());
-        QPen pen(guidingLineColor, guidingLineThickness, Qt::SolidLine);
-        painter.setPen(pen);
-        painter.setRenderHint(QPainter::Antialiasing);
-        painter.drawLine(QPointF(0, viewport()->height() * guidingLinePos ), QPointF(viewport()->width(), viewport()->height() * guidingLinePos) );
+    PipelineMetrics * metrics = PipelineMetrics::instance();
+    metrics->record(PipelineMetrics::PAINT, PipelineMetrics::now() - paintStart);
+    if (isFramePending) {
+        metrics->countFrameShown();
+        metrics->record(PipelineMetrics::CAPTURE_TO_PRESENT, PipelineMetrics::now() - pendingCaptureTime);
+        isFramePending = false;
     }
+
+    if (calibrator->isActive()) {
+        calibrator->framePainted();
+    }
+
+    emit painted();
 }
 
 /*
- * Change the webcam to the index of the device specified
+ * Play live video again when the window is shown (e.g. restored after being minimized)
  */
-bool WebcamView::openWebcam(int device) {
-    bool isOpened = videoPlayer->open(device);
-    if (!isOpened) {
-        handleError();
+void WebcamView::showEvent(QShowEvent * event) {
+    QGraphicsView::showEvent(event);
+
+    // Window may have moved to a screen with a different refresh rate
+    QWindow * windowHandle = window()->windowHandle();
+    if (windowHandle != nullptr) {
+        connect(windowHandle, SIGNAL (screenChanged(QScreen *)),
+                this, SLOT (updateFramePacing()), Qt::UniqueConnection);
     }
-    else {
-        switch (mode) {
-            case PREVIEW:
-                videoPlayer->play();
-                break;
-            case SNAPSHOT:
-                break;
-            case ERROR:
-            default:
-                handleError();
-                break;
-        }
+    updateFramePacing();
+
+    isOnScreen = true;
+    resumeVideo();
+}
+
+/*
+ * Stop live video while the window is hidden or minimized
+ */
+void WebcamView::hideEvent(QHideEvent * event) {
+    QGraphicsView::hideEvent(event);
+
+    isOnScreen = false;
+    pauseVideo();
+}
+
+/*
+ * Stop reading frames that can't be seen, and close the webcam if that lasts
+ */
+void WebcamView::pauseVideo() {
+    videoPlayer->stop();
+    suspendTimer.start();
+}
+
+/*
+ * Play live video again, in the modes that show it (a suspended webcam is reopened first)
+ */
+void WebcamView::resumeVideo() {
+    if (mode == PREVIEW || mode == PANORAMA) {
+        suspendTimer.stop();
+        videoPlayer->play();
     }
+}
+
+/*
+ * Close the webcam while there is still no live video to show, to save power
+ */
+void WebcamView::suspendVideo() {
+    if (!isOnScreen || mode == SNAPSHOT) {
+        videoPlayer->suspend();
+    }
+}
 
-    return isOpened;
+/*
+ * Keep overlays in place while dragging the image (scrolling the view), which makes the high quality image outdated
+ */
+void WebcamView::scrollContentsBy(int dx, int dy) {
+    QGraphicsView::scrollContentsBy(dx, dy);
+
+    updateOverlays();
+    restartRefinement();
+}
+
+/*
+ * Change the webcam to the index of the device specified. The device is opened by the video player's
+ * thread when it next plays, and errors are reported through handleError()
+ */
+void WebcamView::openWebcam(int device) {
+    videoPlayer->open(device);
+    playOpeningSource();
+}
+
+/*
+ * Play frames from another source than a webcam (e.g. a recording, to reproduce problems without the webcam)
+ */
+void WebcamView::openSource(cv::Ptr<FrameSource> source) {
+    videoPlayer->open(source);
+    playOpeningSource();
+}
+
+/*
+ * Start playing while the new source opens in the background
+ */
+void WebcamView::playOpeningSource() {
+    switch (mode) {
+        case PREVIEW:
+        case PANORAMA:
+            // Keep showing the last frame (if any) until the new source's first frame arrives
+            if (image.isNull()) {
+                statusMessage.setText(OPENING_MESSAGE);
+                statusMessage.setVisible(true);
+            }
+            videoPlayer->play();
+            break;
+        case SNAPSHOT:
+        case ERROR:
+        default:
+            break;
+    }
 }
 
 WebcamView::~WebcamView() {
+    // Image items are owned by the view, not the scene
+    if (imageItem.scene() != nullptr) {
+        scene->removeItem(&imageItem);
+    }
+    scene->removeItem(&tiledItem);
+    scene->removeItem(&refinedItem);
+    for (OverlayItem * overlay : overlays) {
+        scene->removeItem(overlay);
+    }
 }
 
 
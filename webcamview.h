@@ -8,13 +8,39 @@
 #include <string>
 
 #include <QEvent>
+#include <QGuiApplication>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsScene>
+#include <QHideEvent>
+#include <QList>
 #include <QMouseEvent>
-#include <QSettings>
+#include <QPixmapCache>
+#include <QPointF>
+#include <QResizeEvent>
+#include <QScreen>
+#include <QSharedPointer>
+#include <QShowEvent>
+#include <QTimer>
+#include <QWindow>
 
 #include <opencv2/core.hpp>
 
+#include "documentwriter.h"
+#include "frameitem.h"
+#include "guidinglineitem.h"
+#include "imagerefiner.h"
+#include "latencycalibrator.h"
+#include "messageitem.h"
+#include "overlayitem.h"
+#include "pyramidbuilder.h"
+#include "settingsmodel.h"
+#include "pipelinemetrics.h"
+#include "snapshotfile.h"
+#include "snapshothistory.h"
+#include "snapshotprocessor.h"
+#include "statsitem.h"
+#include "tiledimageitem.h"
+#include "tracer.h"
 #include "webcamplayer.h"
 
 class WebcamView : public QGraphicsView {
@@ -28,6 +54,8 @@ public:
         SNAPSHOT = 1,
         // Webcam not detected
         ERROR = 2,
+        // Display page mosaic being stitched from the webcam as the page moves
+        PANORAMA = 3,
     };
 
 private:
@@ -41,44 +69,147 @@ private:
     int mouseOriginX;
     int mouseOriginY;
 
-    bool guidingLineEnabled = false;
-    double guidingLinePos = 0.5;
-    int guidingLineThickness = 10;
-    QColor guidingLineColor = Qt::black;
+    // Items drawn at fixed viewport positions over the image
+    GuidingLineItem guidingLine;
+    // Shown instead of the video until the first frame arrives, or if there is no webcam
+    MessageItem statusMessage;
+    QList<OverlayItem *> overlays;
+    bool isFirstFrameShown = false;
+
+    // Frame rate & stage timings, shown on demand
+    StatsItem statsOverlay;
+    QTimer statsTimer;
+    quint64 lastFramesShown = 0;
+    qint64 lastStatsTime = 0;
+    // Whether a video frame was received but not painted yet, and when it was read from the webcam
+    bool isFramePending = false;
+    qint64 pendingCaptureTime = 0;
+
+    // Frames are taken from the player once per display refresh (or less often, if capped)
+    QTimer presentTimer;
+    qint64 presentInterval = 0;
+    qint64 lastPresentTime = 0;
+    int maxFps = 0;
+
+    // Closes the webcam after a while without live video (snapshot mode or hidden window)
+    QTimer suspendTimer;
+    // Whether the view is on screen (it's still "visible" while the window is minimized)
+    bool isOnScreen = true;
+
+    // Flashes the viewport to measure the delay from screen to webcam to screen
+    PatchItem calibrationPatch;
+    LatencyCalibrator * calibrator;
 
     // Copy of current image/frame
     QImage image;
-    QImage snapshotImage;
-    // Graphical representation of image in view
-    QGraphicsPixmapItem imageItem;
+    bool hasSnapshot = false;
+    // Graphical representation of image in view (drawn at native resolution)
+    FrameItem imageItem;
+    // Snapshot image split into tiles at multiple resolutions, shown instead once built
+    TiledImageItem tiledItem;
+    PyramidBuilder * pyramidBuilder;
+    // Processes snapshot in the background when settings change
+    SnapshotProcessor * snapshotProcessor;
+    int snapshotRequest = 0;
+    // Settings that the displayed snapshot was processed with
+    ImageSettings snapshotSettings;
+    bool isSnapshotProcessed = false;
+    // Every snapshot taken, and the one chosen from it to be shown next
+    SnapshotHistory * history;
+    int historyRequest = -1;
+    cv::Mat restoredSnapshot;
+    // Unmodified snapshot, kept to save the session with
+    cv::Mat snapshotSource;
+    // Whether the image is the processed snapshot (not a preview or the last frame), and its settings
+    bool isSnapshotShown = false;
+    ImageSettings shownSettings;
+    // File the snapshot was restored from, drawn straight from its tiles until it's processed again
+    QSharedPointer<SnapshotFile> sessionFile;
+    // Point of the restored snapshot kept at the centre until the view is moved
+    QPointF restoredCenter;
+    bool isCenterRestored = false;
+    // Document that new snapshots are added to as pages (null unless one is being made)
+    DocumentWriter * document = nullptr;
+    // High quality resample of the visible part of a snapshot, shown once zooming & dragging stop
+    QGraphicsPixmapItem refinedItem;
+    ImageRefiner * imageRefiner;
+    QTimer refineTimer;
+    int refineRequest = 0;
+    // Zoom relative to the image filling the viewport
+    double zoomFactor = 1;
+
+    void updateTransform();
+    void setTiledImageVisible(bool isVisible);
+    void buildPyramid(const QImage & img);
+    void restartRefinement();
+    void addOverlay(OverlayItem * overlay);
+    void updateOverlays();
+    void playOpeningSource();
+    void pauseVideo();
+    void resumeVideo();
+    void showSessionFile(QSharedPointer<SnapshotFile> file);
+    void keepSnapshot(const cv::Mat & snapshot);
 
 protected slots:
     void handleError();
-    void updateImage(QImage img);
-    void setSnapshotImage(const QImage & img);
+    void presentFrame();
+    void updateFramePacing();
+    void updateImage(QImage img, qint64 capturedAt = 0, qint64 processedAt = 0);
+    void setSnapshotImage(const cv::Mat & img);
+    void showPyramid();
+    void showSnapshotPreview(const QImage & preview, double previewScale, int requestId);
+    void showProcessedSnapshot(const QImage & img, int requestId);
+    void showHistorySnapshot();
+    void refineVisibleRegion();
+    void showRefinedImage();
+    void updateStats();
+    void showLatencyCalibration(bool isMeasured, double medianMs);
+    void suspendVideo();
 
 protected:
     void mousePressEvent(QMouseEvent * event);
     void mouseMoveEvent(QMouseEvent * event);
     void leaveEvent(QEvent * event);
+    void resizeEvent(QResizeEvent * event);
     void paintEvent(QPaintEvent * event);
+    void showEvent(QShowEvent * event);
+    void hideEvent(QHideEvent * event);
+    void scrollContentsBy(int dx, int dy);
 
     void setDragging(bool isDragging);
     bool isDragging();
 
 public:
 
+    // Time without zooming or dragging before the visible part of a snapshot is resampled in high quality
+    const int REFINE_DELAY_MS = 250;
+
+    const int STATS_INTERVAL_MS = 500;
+
+    // Refresh rate assumed when the screen doesn't report one
+    const double DEFAULT_REFRESH_RATE = 60;
+    // How early a frame can be presented before the next refresh is due
+    const qint64 PRESENT_SLACK_NS = 1000000;
+
+    // Time without live video before the webcam is closed to save power
+    const int SUSPEND_DELAY_MS = 30000;
+
+    const char * OPENING_MESSAGE = "Starting camera...";
+    const char * ERROR_MESSAGE = "Cannot find camera";
+
     Mode DEFAULT_MODE = PREVIEW;
     int DEFAULT_DEVICE = 0;
 
-    WebcamView(QWidget * parent = nullptr);
+    WebcamView(QWidget * parent = nullptr, cv::Ptr<FrameSource> source = cv::Ptr<FrameSource>());
     WebcamView(int device = 0, QWidget * parent = nullptr);
     ~WebcamView();
 
-    void init(Mode mode, int device, QWidget * parent);
-    bool openWebcam(int device);
+    void init(Mode mode, int device, QWidget * parent, cv::Ptr<FrameSource> source = cv::Ptr<FrameSource>());
+    void openWebcam(int device);
+    void openSource(cv::Ptr<FrameSource> source);
     Mode getMode();
     void resize();
+    void setZoom(double zoomFactor);
     void setMode(Mode mode);
     void setContrast(double contrast);
     void setClickToDragEnabled(bool isClickToDrag);
@@ -96,10 +227,25 @@ public:
     int getWebcam();
     int getRotation();
     bool isGuidingLineEnabled();
+    void setStatsVisible(bool isVisible);
+    void setMaxFps(int fps);
+    void startLatencyCalibration();
+    bool isStatsVisible();
     void processSnapshotImage();
+    SnapshotHistory * getHistory();
+    void setDocument(DocumentWriter * document);
+    double getZoom();
+    bool restoreSession(const QString & path);
+    bool saveSession(const QString & path);
+
+public slots:
+    void showSnapshot(int id);
 
 signals:
     void modeChanged();
+    void firstFrameShown();
+    // After every paint of the viewport (to measure how quickly input is shown)
+    void painted();
 
 };
 